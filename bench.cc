@@ -0,0 +1,40 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+/*
+ * Simulator performance on a fixed set of reference scenarios, for
+ * comparing ns-3 releases, schedulers and build flags, e.g.
+ *
+ *   ./waf --run "bench --repeats=7 --output=bench-3.19-optimized.jsonl"
+ *   ./waf --run "bench --only=part2 --scheduler=ns3::HeapScheduler"
+ *
+ * See benchmark.h for the scenarios and methodology.
+ */
+
+#include "ns3/core-module.h"
+
+#include "benchmark.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("Bench");
+
+int
+main (int argc, char *argv[])
+{
+  return BenchMain (argc, argv);
+}
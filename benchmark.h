@@ -0,0 +1,267 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include "ns3/core-module.h"
+
+#include "scenario.h"
+#include "trial.h"
+#include "trial-cost.h"
+#include "result-cache.h"
+#include "sweep-runner.h"
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdio.h>
+
+namespace ns3 {
+
+struct BenchScenario
+{
+  std::string name;
+  TrialSpec spec;
+};
+
+/*
+ * The reference scenarios: part1's two-node world at both ends of its
+ * distance range, with and without fading, and part2's and part3's cells
+ * at 1, 16 and 46 stations with random flow directions, all under both
+ * managers.  Seed and run are fixed, so every repeat of a scenario does
+ * exactly the same work.  Never change an existing entry; numbers are only
+ * comparable while the names mean the same thing.
+ */
+inline std::vector<BenchScenario>
+GetBenchScenarios (void)
+{
+  std::vector<BenchScenario> scenarios;
+  const char *const managers[] = { "aarf", "cara" };
+  const char *const fadings[] = { "none", "rayleigh" };
+  const char *const distances[] = { "5", "100" };
+  for (uint32_t m = 0; m < 2; m++)
+    {
+      for (uint32_t f = 0; f < 2; f++)
+        {
+          for (uint32_t d = 0; d < 2; d++)
+            {
+              BenchScenario s;
+              s.name = std::string ("part1-") + managers[m] + "-" + fadings[f] + "-" + distances[d] + "m";
+              s.spec.Set ("manager", managers[m]);
+              s.spec.Set ("fading", fadings[f]);
+              s.spec.Set ("distance", distances[d]);
+              scenarios.push_back (s);
+            }
+        }
+    }
+  const char *const stations[] = { "1", "16", "46" };
+  for (uint32_t part = 2; part <= 3; part++)
+    {
+      for (uint32_t m = 0; m < 2; m++)
+        {
+          for (uint32_t n = 0; n < 3; n++)
+            {
+              BenchScenario s;
+              s.name = std::string (part == 2 ? "part2-" : "part3-") + managers[m] + "-" + stations[n] + "st";
+              s.spec.Set ("manager", managers[m]);
+              s.spec.Set ("placement", "disc");
+              s.spec.Set ("stations", stations[n]);
+              s.spec.Set ("direction", "random");
+              if (part == 3)
+                {
+                  s.spec.Set ("fading", "rayleigh");
+                  s.spec.Set ("rho-min", "0");
+                  s.spec.Set ("rho-max", "25");
+                }
+              scenarios.push_back (s);
+            }
+        }
+    }
+  return scenarios;
+}
+
+inline double
+GetMedian (std::vector<double> values)
+{
+  std::sort (values.begin (), values.end ());
+  uint32_t n = values.size ();
+  return n == 0 ? 0.0 : (n % 2 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2);
+}
+
+/*
+ * Runs every scenario "repeats" times, one trial at a time so that trials
+ * never compete for the machine, each in a fresh forked process.  Repeats
+ * go round-robin over the scenarios, so slow drift in the machine (thermal
+ * throttling, other load) spreads over all of them instead of landing on
+ * the last few.  Reports medians, which one disturbed repeat cannot move.
+ */
+class Benchmark
+{
+public:
+  Benchmark (const std::vector<BenchScenario> &scenarios, uint32_t repeats);
+
+  void Run (void);
+  void Print (FILE *out) const;
+  void Write (const std::string &filename) const;
+
+private:
+  std::string RunOne (uint32_t i); // runs in a forked child
+  static std::string GetBuild (void);
+
+  std::vector<BenchScenario> m_scenarios;
+  uint32_t m_repeats;
+  std::vector<std::vector<TrialResult> > m_results; // per scenario, one per repeat
+};
+
+inline
+Benchmark::Benchmark (const std::vector<BenchScenario> &scenarios, uint32_t repeats)
+  : m_scenarios (scenarios),
+    m_repeats (repeats)
+{
+  NS_ABORT_MSG_IF (repeats == 0, "need at least one repeat");
+}
+
+inline std::string
+Benchmark::RunOne (uint32_t i)
+{
+  return RunTrial (m_scenarios[i % m_scenarios.size ()].spec).ToString ();
+}
+
+inline void
+Benchmark::Run (void)
+{
+  std::vector<std::string> out = SweepRunner (1).Run (m_scenarios.size () * m_repeats,
+                                                      MakeCallback (&Benchmark::RunOne, this));
+  m_results.assign (m_scenarios.size (), std::vector<TrialResult> ());
+  for (uint32_t i = 0; i < out.size (); i++)
+    {
+      m_results[i % m_scenarios.size ()].push_back (TrialResult::Parse (out[i]));
+    }
+}
+
+// what the numbers were measured with, for comparing across builds
+inline std::string
+Benchmark::GetBuild (void)
+{
+#ifdef NS3_LOG_ENABLE
+  std::string build = "debug";
+#else
+  std::string build = "optimized";
+#endif
+  return build + " " + GetNs3Version () + " " + CountingScheduler::GetInnerType () + " " + __VERSION__;
+}
+
+inline void
+Benchmark::Print (FILE *out) const
+{
+  fprintf (out, "# %s, median of %u\n", GetBuild ().c_str (), m_repeats);
+  fprintf (out, "%-22s %12s %10s %10s %12s %10s %10s\n",
+           "scenario", "events", "wall s", "run s", "events/s", "sim/real", "rss KiB");
+  for (uint32_t s = 0; s < m_scenarios.size (); s++)
+    {
+      std::vector<double> wall, run;
+      uint64_t rss = 0;
+      for (uint32_t r = 0; r < m_results[s].size (); r++)
+        {
+          wall.push_back (m_results[s][r].wallSeconds);
+          run.push_back (m_results[s][r].runSeconds);
+          rss = std::max (rss, m_results[s][r].peakRss);
+        }
+      double medianRun = GetMedian (run);
+      const TrialResult &first = m_results[s][0];
+      fprintf (out, "%-22s %12llu %10.3f %10.3f %12.0f %10.2f %10llu\n",
+               m_scenarios[s].name.c_str (), (unsigned long long)first.events, GetMedian (wall), medianRun,
+               medianRun > 0 ? first.events / medianRun : 0.0, medianRun > 0 ? first.simSeconds / medianRun : 0.0,
+               (unsigned long long)rss);
+    }
+}
+
+/*
+ * One JSON object per scenario and repeat, with the build it ran on, so
+ * files from different builds can simply be concatenated and compared.
+ */
+inline void
+Benchmark::Write (const std::string &filename) const
+{
+  FILE *f = fopen (filename.c_str (), "w");
+  NS_ABORT_MSG_UNLESS (f, "cannot open \"" << filename << "\"");
+  std::string build = GetBuild ();
+  for (uint32_t s = 0; s < m_scenarios.size (); s++)
+    {
+      for (uint32_t r = 0; r < m_results[s].size (); r++)
+        {
+          const TrialResult &result = m_results[s][r];
+          fprintf (f, "{\"scenario\":\"%s\",\"build\":\"%s\",\"repeat\":%u,\"events\":%llu,\"wall\":%s,"
+                   "\"setup-wall\":%s,\"run-wall\":%s,\"teardown-wall\":%s,\"sim\":%s,\"peak-rss\":%llu,"
+                   "\"spec\":\"%s\"}\n",
+                   m_scenarios[s].name.c_str (), build.c_str (), r, (unsigned long long)result.events,
+                   SweepRunner::FormatDouble (result.wallSeconds).c_str (),
+                   SweepRunner::FormatDouble (result.setupSeconds).c_str (),
+                   SweepRunner::FormatDouble (result.runSeconds).c_str (),
+                   SweepRunner::FormatDouble (result.teardownSeconds).c_str (),
+                   SweepRunner::FormatDouble (result.simSeconds).c_str (),
+                   (unsigned long long)result.peakRss, m_scenarios[s].spec.ToString ().c_str ());
+        }
+    }
+  fclose (f);
+}
+
+inline int
+BenchMain (int argc, char *argv[])
+{
+  uint32_t repeats = 5;
+  std::string only;
+  std::string scheduler = CountingScheduler::GetInnerType ();
+  std::string output;
+  std::string ns3Version = Ns3Version (); // the build's, if it set one
+
+  CommandLine cmd;
+  cmd.AddValue ("repeats", "Times each scenario runs; the median is reported", repeats);
+  cmd.AddValue ("only", "Run only the scenarios whose name contains this", only);
+  cmd.AddValue ("scheduler", "Event scheduler TypeId to measure, e.g. ns3::HeapScheduler", scheduler);
+  cmd.AddValue ("output", "Also write every repeat to this file as JSON lines", output);
+  cmd.AddValue ("ns3-version", "ns-3 release being measured, e.g. ns-3.19; reported with every number", ns3Version);
+  cmd.Parse (argc, argv);
+  SetNs3Version (ns3Version);
+  GetNs3Version (); // refuse now, not after the last repeat
+  CountingScheduler::SetInnerType (scheduler);
+
+  std::vector<BenchScenario> all = GetBenchScenarios ();
+  std::vector<BenchScenario> scenarios;
+  for (uint32_t i = 0; i < all.size (); i++)
+    {
+      if (all[i].name.find (only) != std::string::npos)
+        {
+          scenarios.push_back (all[i]);
+        }
+    }
+  NS_ABORT_MSG_IF (scenarios.empty (), "no scenario matches \"" << only << "\"");
+
+  Benchmark bench (scenarios, repeats);
+  bench.Run ();
+  bench.Print (stdout);
+  if (!output.empty ())
+    {
+      bench.Write (output);
+    }
+  return 0;
+}
+
+} // namespace ns3
+
+#endif /* BENCHMARK_H */
@@ -0,0 +1,123 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef BLOCK_FADING_H
+#define BLOCK_FADING_H
+
+#include "ns3/core-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/propagation-module.h"
+#include "ns3/rng-stream.h"
+
+#include <vector>
+#include <math.h>
+
+namespace ns3 {
+
+/*
+ * Rayleigh fading (Nakagami with m = 1, whose power gain is exponential
+ * with mean 1) with the gains drawn a block at a time.  A refill takes
+ * BLOCK uniforms straight from an RngStream, the same one a
+ * UniformRandomVariable set to the model's stream number would draw from,
+ * with no virtual call per sample, then turns them into gains in dB; each
+ * frame then just adds the next gain to the incoming power.  Only m = 1
+ * is drawn this way: other m need gamma draws, which are not a fixed
+ * number of uniforms each, and TrialSpec accepts no other fading.  The same seed, run and stream give the same sequence
+ * of gains, so trials stay reproducible, but it is not the sequence
+ * NakagamiPropagationLossModel draws.
+ */
+class BlockRayleighPropagationLossModel : public PropagationLossModel
+{
+public:
+  static TypeId GetTypeId (void);
+
+  BlockRayleighPropagationLossModel ();
+  virtual ~BlockRayleighPropagationLossModel ();
+
+private:
+  static const uint32_t BLOCK = 1024;
+
+  virtual double DoCalcRxPower (double txPowerDbm, Ptr<MobilityModel> a, Ptr<MobilityModel> b) const;
+  virtual int64_t DoAssignStreams (int64_t stream);
+  void Refill (void) const;
+
+  RngStream *m_rng; // 0 until AssignStreams
+  mutable std::vector<double> m_gainDb;
+  mutable uint32_t m_next;
+};
+
+inline TypeId
+BlockRayleighPropagationLossModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::BlockRayleighPropagationLossModel")
+    .SetParent<PropagationLossModel> ()
+    .AddConstructor<BlockRayleighPropagationLossModel> ();
+  return tid;
+}
+
+inline
+BlockRayleighPropagationLossModel::BlockRayleighPropagationLossModel ()
+  : m_rng (0),
+    m_gainDb (BLOCK),
+    m_next (BLOCK)
+{
+}
+
+inline
+BlockRayleighPropagationLossModel::~BlockRayleighPropagationLossModel ()
+{
+  delete m_rng;
+}
+
+inline void
+BlockRayleighPropagationLossModel::Refill (void) const
+{
+  NS_ABORT_MSG_UNLESS (m_rng, "BlockRayleighPropagationLossModel needs AssignStreams before its first frame");
+  double *g = &m_gainDb[0];
+  for (uint32_t i = 0; i < BLOCK; i++)
+    {
+      g[i] = m_rng->RandU01 (); // in (0, 1), never 0
+    }
+  for (uint32_t i = 0; i < BLOCK; i++)
+    {
+      g[i] = 10 * log10 (-log (g[i])); // exponential(1) power gain, in dB
+    }
+  m_next = 0;
+}
+
+inline double
+BlockRayleighPropagationLossModel::DoCalcRxPower (double txPowerDbm, Ptr<MobilityModel>, Ptr<MobilityModel>) const
+{
+  if (m_next == BLOCK)
+    {
+      Refill ();
+    }
+  return txPowerDbm + m_gainDb[m_next++];
+}
+
+inline int64_t
+BlockRayleighPropagationLossModel::DoAssignStreams (int64_t stream)
+{
+  delete m_rng;
+  m_rng = new RngStream (SeedManager::GetSeed (), (1ULL << 63) + stream, SeedManager::GetRun ()); // as RandomVariableStream::SetStream (stream) would
+  m_next = BLOCK; // drop anything drawn from the old stream
+  return 1;
+}
+
+} // namespace ns3
+
+#endif /* BLOCK_FADING_H */
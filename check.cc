@@ -0,0 +1,337 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+/*
+ * Checks of the sweep engine's parts that need no simulation to go
+ * wrong: specs and results surviving their text forms, sweeps expanding
+ * their value lists, the result cache's log, the replication statistics,
+ * antithetic pairing and the delay histograms; then, in one short
+ * simulation, that trials batched together get the results they get
+ * alone.
+ *
+ *   ./waf --run check
+ *
+ * prints every failed check and exits non-zero if there was one.
+ */
+
+#include "ns3/core-module.h"
+
+#include "sweep.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("Check");
+
+static uint32_t g_checks = 0;
+static uint32_t g_failures = 0;
+
+// carries on after a failure, so that one run shows all of them
+static void
+Check (bool ok, const std::string &what)
+{
+  g_checks++;
+  if (!ok)
+    {
+      fprintf (stderr, "FAILED: %s\n", what.c_str ());
+      g_failures++;
+    }
+}
+
+static void
+CheckEqual (const std::string &got, const std::string &wanted, const std::string &what)
+{
+  Check (got == wanted, what + ": got \"" + got + "\", wanted \"" + wanted + "\"");
+}
+
+static void
+CheckNear (double got, double wanted, double tolerance, const std::string &what)
+{
+  Check (fabs (got - wanted) <= tolerance,
+         what + ": got " + SweepRunner::FormatDouble (got) + ", wanted " + SweepRunner::FormatDouble (wanted));
+}
+
+static std::string
+Join (const std::vector<std::string> &values)
+{
+  std::string s;
+  for (uint32_t i = 0; i < values.size (); i++)
+    {
+      s += (i ? "," : "") + values[i];
+    }
+  return s;
+}
+
+static void
+CheckTrialSpec (void)
+{
+  TrialSpec spec;
+  spec.Set ("placement", "disc");
+  spec.Set ("stations", "12");
+  spec.Set ("distance", "7.5");
+  spec.Set ("fading", "rayleigh");
+  spec.Set ("data-rate", "2Mib/s");
+  spec.Set ("rho-max", "25");
+  spec.Set ("seed", "4");
+  spec.Set ("run", "3");
+  std::string text = spec.ToString ();
+  CheckEqual (TrialSpec::Parse (text).ToString (), text, "TrialSpec Parse (ToString ())");
+  CheckEqual (spec.Get ("distance"), "7.5", "TrialSpec distance");
+  CheckEqual (spec.Get ("stations"), "12", "TrialSpec stations");
+  Check (spec.GetPointKey ().find ("seed=") == std::string::npos
+         && spec.GetPointKey ().find ("run=") == std::string::npos, "TrialSpec point key leaves out seed and run");
+
+  TrialSpec other = spec;
+  other.Set ("seed", "6");
+  CheckEqual (other.GetPointKey (), spec.GetPointKey (), "TrialSpec point key of another seed");
+}
+
+static void
+CheckSweepSpec (void)
+{
+  SweepSpec sweep;
+  sweep.Set ("distance", "5:5:20");
+  CheckEqual (Join (sweep.GetValues ("distance")), "5,10,15,20", "SweepSpec range");
+  sweep.Set ("distance", "0.1:0.1:0.3");
+  CheckEqual (Join (sweep.GetValues ("distance")), "0.1,0.2,0.3", "SweepSpec fractional range");
+  sweep.Set ("stations", " 1, 4:2:8 ,20");
+  CheckEqual (Join (sweep.GetValues ("stations")), "1,4,6,8,20", "SweepSpec list of values and ranges");
+  CheckEqual (Join (sweep.GetValues ("seed")), "2,4,6,8,10", "SweepSpec default seeds");
+  CheckEqual (sweep.GetRowKey (), "distance", "SweepSpec row key is the innermost axis");
+
+  sweep.Set ("seed", "1,2");
+  sweep.Set ("distance", "5");
+  CheckEqual (sweep.GetRowKey (), "stations", "SweepSpec row key once distance is fixed");
+  std::vector<TrialSpec> trials = sweep.Expand ();
+  Check (trials.size () == 5 * 2, "SweepSpec Expand gives every point every seed");
+  CheckEqual (trials[0].Get ("stations") + " " + trials[0].Get ("seed"), "1 1", "SweepSpec Expand order, first");
+  CheckEqual (trials[1].Get ("stations") + " " + trials[1].Get ("seed"), "1 2", "SweepSpec Expand order, second");
+}
+
+static void
+CheckTrialResult (void)
+{
+  TrialResult result;
+  result.throughput = 1234.5678901234567;
+  result.uplinkThroughput = 1000.0 / 3;
+  result.downlinkThroughput = 0.1;
+  result.wallSeconds = 2.5;
+  result.events = 123456789012ULL;
+  result.peakRss = 54321;
+  result.simSeconds = 10.0;
+  result.delays = DelayHistogram::Parse ("0.001;0:10;3:2");
+  FlowResult flow;
+  flow.source = "10.1.1.2";
+  flow.destination = "10.1.1.1";
+  flow.txPackets = 100;
+  flow.rxPackets = 97;
+  flow.delaySum = 0.123456789;
+  flow.direction = "uplink";
+  flow.throughput = 1234.5678901234567;
+  result.flows.push_back (flow);
+  result.flows.push_back (flow);
+  result.flows[1].direction = "downlink";
+
+  std::string text = result.ToString ();
+  TrialResult parsed = TrialResult::Parse (text);
+  CheckEqual (parsed.ToString (), text, "TrialResult Parse (ToString ())");
+  Check (parsed.throughput == result.throughput && parsed.uplinkThroughput == result.uplinkThroughput,
+         "TrialResult doubles read back exactly");
+  Check (parsed.flows.size () == 2 && parsed.flows[1].direction == "downlink", "TrialResult flows");
+  CheckNear (parsed.GetLossRate (), 0.03, 1e-12, "TrialResult loss rate");
+  Check (text.find_first_of ("\t\n") == std::string::npos, "TrialResult is one tab-free line");
+}
+
+static void
+CheckResultCache (void)
+{
+  char dir[] = "/tmp/check-cache-XXXXXX";
+  Check (mkdtemp (dir) != 0, "ResultCache scratch directory");
+  SetNs3Version ("ns-3.19");
+  TrialSpec a;
+  TrialSpec b;
+  b.Set ("distance", "50");
+  {
+    ResultCache cache (dir);
+    cache.Store (a, "throughput=1");
+    cache.Store (b, "throughput=2");
+  }
+
+  // a child killed in the middle of its write leaves half a line at the end of the log
+  std::string path = std::string (dir) + "/results.log";
+  int fd = open (path.c_str (), O_WRONLY | O_APPEND);
+  std::string torn = "0123456789abcdef\tplacement=line";
+  Check (fd >= 0 && write (fd, torn.data (), torn.size ()) == (ssize_t)torn.size (), "ResultCache torn write");
+  close (fd);
+
+  TrialSpec c;
+  c.Set ("distance", "75");
+  {
+    ResultCache cache (dir);
+    Check (cache.GetSize () == 2, "ResultCache skips a torn line");
+    std::string result;
+    Check (cache.Lookup (a, result) && result == "throughput=1", "ResultCache Lookup after reload");
+    Check (cache.Lookup (b, result) && result == "throughput=2", "ResultCache Lookup of the last whole line");
+    Check (!cache.Lookup (c, result), "ResultCache Lookup of a trial never stored");
+    cache.Store (c, "throughput=3");
+  }
+  {
+    ResultCache cache (dir);
+    std::string result;
+    Check (cache.GetSize () == 3 && cache.Lookup (c, result) && result == "throughput=3",
+           "ResultCache keeps a line stored after a torn one");
+  }
+
+  SetNs3Version ("ns-3.20");
+  {
+    ResultCache cache (dir);
+    std::string result;
+    Check (!cache.Lookup (a, result), "ResultCache keeps ns-3 releases apart");
+  }
+  unlink (path.c_str ());
+  rmdir (dir);
+}
+
+static void
+CheckReplication (void)
+{
+  // tabled two-sided 95% and 99% points
+  CheckNear (StudentTQuantile (0.975, 1), 12.706, 0.001, "t(0.975, 1)");
+  CheckNear (StudentTQuantile (0.975, 2), 4.303, 0.001, "t(0.975, 2)");
+  CheckNear (StudentTQuantile (0.975, 4), 2.776, 0.03, "t(0.975, 4)");
+  CheckNear (StudentTQuantile (0.975, 9), 2.262, 0.005, "t(0.975, 9)");
+  CheckNear (StudentTQuantile (0.995, 29), 2.756, 0.005, "t(0.995, 29)");
+  CheckNear (StudentTQuantile (0.975, 1000), 1.962, 0.001, "t(0.975, 1000)");
+  CheckNear (NormalQuantile (0.5), 0.0, 1e-9, "z(0.5)");
+  CheckNear (NormalQuantile (0.01), -2.326348, 1e-6, "z(0.01)");
+
+  ReplicationStats stats;
+  double x[] = { 2, 4, 4, 4, 5, 5, 7, 9 };
+  for (uint32_t i = 0; i < 8; i++)
+    {
+      stats.Add (x[i]);
+    }
+  Check (stats.GetN () == 8, "ReplicationStats n");
+  CheckNear (stats.GetMean (), 5.0, 1e-12, "ReplicationStats mean");
+  CheckNear (stats.GetStdDev (), sqrt (32.0 / 7), 1e-12, "ReplicationStats sample standard deviation");
+  CheckNear (stats.GetHalfWidth (0.95), StudentTQuantile (0.975, 7) * sqrt (32.0 / 7) / sqrt (8.0), 1e-12,
+             "ReplicationStats half-width");
+  Check (stats.GetWanted (1.0, 0.95) == 8, "ReplicationStats wants no more once within target");
+  Check (stats.GetWanted (0.01, 0.95) > 8, "ReplicationStats wants more while too wide");
+
+  ReplicationStats one;
+  one.Add (1.0);
+  Check (one.GetHalfWidth (0.95) > 1e300, "ReplicationStats half-width of one replication");
+  Check (one.GetWanted (0.1, 0.95) == 2, "ReplicationStats wants a second replication");
+}
+
+static void
+CheckAntithetic (void)
+{
+  SweepSpec sweep;
+  sweep.Set ("placement", "antithetic");
+  sweep.Set ("seed", "3, 5");
+  sweep.Set ("run", "1");
+  TrialSpec point = sweep.ExpandPoints ()[0];
+  CheckEqual (Join (sweep.GetRuns (point)), "1,2", "antithetic run 1 brings run 2");
+  CheckEqual (sweep.GetReplication (point, 1).Get ("seed") + " " + sweep.GetReplication (point, 1).Get ("run"), "3 2",
+              "antithetic replication 1 is the second half of pair 0");
+  CheckEqual (sweep.GetReplication (point, 2).Get ("seed") + " " + sweep.GetReplication (point, 2).Get ("run"), "5 1",
+              "antithetic replication 2 starts the next seed's pair");
+  CheckEqual (sweep.GetReplication (point, 4).Get ("seed") + " " + sweep.GetReplication (point, 4).Get ("run"), "3 3",
+              "antithetic replications move on by a pair of runs");
+
+  ReplicationStats stats;
+  double x[] = { 1, 3, 5, 9 };
+  AddSamples (stats, point, std::vector<double> (x, x + 4));
+  Check (stats.GetN () == 2, "antithetic points count pairs");
+  CheckNear (stats.GetMean (), 4.5, 1e-12, "antithetic mean over pair means");
+  CheckNear (stats.GetStdDev (), sqrt (12.5), 1e-12, "antithetic standard deviation over pair means");
+}
+
+static void
+CheckDelayHistogram (void)
+{
+  DelayHistogram h = DelayHistogram::Parse ("0.001;0:10;2:10");
+  Check (h.GetCount () == 20, "DelayHistogram count");
+  CheckNear (h.GetQuantile (0.5), 0.001, 1e-12, "DelayHistogram median at a bin edge");
+  CheckNear (h.GetQuantile (0.95), 0.0029, 1e-12, "DelayHistogram p95 within a bin");
+  CheckNear (h.GetQuantile (0.25), 0.0005, 1e-12, "DelayHistogram p25 within the first bin");
+  CheckEqual (DelayHistogram::Parse (h.ToString ()).ToString (), h.ToString (), "DelayHistogram Parse (ToString ())");
+
+  DelayHistogram merged;
+  Check (merged.GetQuantile (0.5) == 0.0, "DelayHistogram quantile of an empty histogram");
+  merged.Merge (DelayHistogram::Parse ("0.001;2:10"));
+  merged.Merge (DelayHistogram::Parse ("0.001;0:10"));
+  CheckEqual (merged.ToString (), h.ToString (), "DelayHistogram Merge adds counts bin by bin");
+}
+
+// what a trial found, leaving out what it cost
+static std::string
+GetOutcome (TrialResult result)
+{
+  result.wallSeconds = result.setupSeconds = result.runSeconds = result.teardownSeconds = 0.0;
+  result.events = result.peakRss = 0;
+  result.batch = 1;
+  result.costed = true;
+  return result.ToString ();
+}
+
+// the one check that simulates: trials batched together must each get what they get alone
+static void
+CheckBatch (void)
+{
+  std::vector<TrialSpec> specs (2);
+  specs[0].Set ("stations", "2");
+  specs[0].Set ("duration", "2");
+  specs[1] = specs[0];
+  specs[1].Set ("placement", "disc");
+  specs[1].Set ("fading", "rayleigh");
+  specs[1].Set ("direction", "downlink");
+
+  std::vector<TrialResult> batched = RunTrials (specs);
+  for (uint32_t k = 0; k < specs.size (); k++)
+    {
+      TrialResult alone = RunTrial (specs[k]);
+      Check (alone.throughput > 0, "batch: trial " + specs[k].ToString () + " carries traffic");
+      CheckEqual (GetOutcome (batched[k]), GetOutcome (alone), "batch: trial " + specs[k].ToString () + " batched and alone");
+      Check (batched[k].batch == 2 && batched[k].costed == (k == 0), "batch: only the first trial carries the cost");
+    }
+}
+
+int
+main (int argc, char *argv[])
+{
+  CommandLine cmd;
+  cmd.Parse (argc, argv);
+
+  CheckTrialSpec ();
+  CheckSweepSpec ();
+  CheckTrialResult ();
+  CheckResultCache ();
+  CheckReplication ();
+  CheckAntithetic ();
+  CheckDelayHistogram ();
+  CheckBatch ();
+
+  printf ("%u checks, %u failed\n", g_checks, g_failures);
+  return g_failures ? 1 : 0;
+}
@@ -0,0 +1,163 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef DELAY_HISTOGRAM_H
+#define DELAY_HISTOGRAM_H
+
+#include "ns3/core-module.h"
+#include "ns3/flow-monitor-module.h"
+
+#include "sweep-runner.h"
+
+#include <string>
+#include <map>
+#include <sstream>
+#include <stdlib.h>
+
+namespace ns3 {
+
+/*
+ * A histogram of delays (or jitters) in bins of a fixed width, keeping
+ * only the bins that were hit.  It is filled from FlowMonitor's own
+ * per-flow histograms, whose bin width the trial sets.  Those are dense,
+ * up to the longest delay seen; this copy, which is what results carry
+ * and sweeps merge, holds only the bins hit, however many packets fell
+ * in them.  Histograms of the same width merge by adding
+ * counts, across flows and across replications, and quantiles come out
+ * interpolated linearly within a bin.
+ *
+ * As text (in result lines) it is "<width>;<bin>:<count>;...", with no
+ * spaces or commas, and Parse (ToString ()) round-trips exactly.
+ */
+class DelayHistogram
+{
+public:
+  DelayHistogram ();
+
+  void Add (const Histogram &histogram, double width); // FlowMonitor's, binned at width
+  void Merge (const DelayHistogram &other);
+  uint64_t GetCount (void) const;
+  double GetQuantile (double q) const;
+
+  std::string ToString (void) const;
+  static DelayHistogram Parse (const std::string &text);
+
+private:
+  double m_width;
+  std::map<uint32_t, uint64_t> m_bins;
+};
+
+inline
+DelayHistogram::DelayHistogram ()
+  : m_width (0.0)
+{
+}
+
+inline void
+DelayHistogram::Add (const Histogram &histogram, double width)
+{
+  Histogram &bins = const_cast<Histogram &> (histogram); // GetBinCount only reads, but isn't const
+  DelayHistogram other;
+  other.m_width = width;
+  for (uint32_t i = 0; i < bins.GetNBins (); i++)
+    {
+      if (bins.GetBinCount (i) > 0)
+        {
+          other.m_bins[i] = bins.GetBinCount (i);
+        }
+    }
+  Merge (other);
+}
+
+inline void
+DelayHistogram::Merge (const DelayHistogram &other)
+{
+  if (other.m_bins.empty ())
+    {
+      return;
+    }
+  if (m_bins.empty ())
+    {
+      m_width = other.m_width;
+    }
+  NS_ABORT_MSG_IF (other.m_width != m_width, "cannot merge delay histograms of bin width " << m_width << " and " << other.m_width);
+  for (std::map<uint32_t, uint64_t>::const_iterator i = other.m_bins.begin (); i != other.m_bins.end (); ++i)
+    {
+      m_bins[i->first] += i->second;
+    }
+}
+
+inline uint64_t
+DelayHistogram::GetCount (void) const
+{
+  uint64_t n = 0;
+  for (std::map<uint32_t, uint64_t>::const_iterator i = m_bins.begin (); i != m_bins.end (); ++i)
+    {
+      n += i->second;
+    }
+  return n;
+}
+
+// 0 for an empty histogram
+inline double
+DelayHistogram::GetQuantile (double q) const
+{
+  double rank = q * GetCount ();
+  double below = 0;
+  for (std::map<uint32_t, uint64_t>::const_iterator i = m_bins.begin (); i != m_bins.end (); ++i)
+    {
+      if (below + i->second >= rank)
+        {
+          return (i->first + (rank - below) / i->second) * m_width;
+        }
+      below += i->second;
+    }
+  return 0.0;
+}
+
+inline std::string
+DelayHistogram::ToString (void) const
+{
+  std::ostringstream os;
+  os << SweepRunner::FormatDouble (m_width);
+  for (std::map<uint32_t, uint64_t>::const_iterator i = m_bins.begin (); i != m_bins.end (); ++i)
+    {
+      os << ";" << i->first << ":" << i->second;
+    }
+  return os.str ();
+}
+
+inline DelayHistogram
+DelayHistogram::Parse (const std::string &text)
+{
+  DelayHistogram histogram;
+  std::istringstream is (text);
+  std::string item;
+  std::getline (is, item, ';');
+  histogram.m_width = SweepRunner::ParseDouble (item);
+  while (std::getline (is, item, ';'))
+    {
+      std::string::size_type colon = item.find (':');
+      NS_ABORT_MSG_IF (colon == std::string::npos, "bad delay histogram \"" << text << "\"");
+      histogram.m_bins[strtoul (item.substr (0, colon).c_str (), 0, 10)] = strtoull (item.substr (colon + 1).c_str (), 0, 10);
+    }
+  return histogram;
+}
+
+} // namespace ns3
+
+#endif /* DELAY_HISTOGRAM_H */
@@ -0,0 +1,178 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef ERROR_TABLE_H
+#define ERROR_TABLE_H
+
+#include "ns3/core-module.h"
+#include "ns3/wifi-module.h"
+
+#include <map>
+#include <vector>
+#include <math.h>
+
+namespace ns3 {
+
+/*
+ * NistErrorRateModel answered from tables.  For every mode, NIST's chunk
+ * success rate is (1 - pe)^nbits with pe depending only on the mode and
+ * the SNR, so one curve per mode covers every chunk size:
+ * q (snr) = -ln (1 - pe), and the success rate is exp (-nbits q).
+ *
+ * A mode's table is built the first time the mode is seen, from NIST's
+ * own answer for a one-bit chunk, at ln (snr) steps of GetStep (), from
+ * -10 to 50 dB, and shared by every PHY in the process.  Lookups
+ * interpolate ln q linearly in ln (snr).  Building checks each interval
+ * at its midpoint: it is used only if q is within 1e-3 relative of NIST
+ * there, which keeps the success rate within 4e-4 of NIST's for any
+ * chunk size, or within 5e-9 absolute, which keeps it within 1e-4 for
+ * chunks up to 20000 bits.  Intervals failing both, and SNRs off the
+ * table, are passed to NIST itself.
+ */
+class TableErrorRateModel : public ErrorRateModel
+{
+public:
+  static TypeId GetTypeId (void);
+
+  TableErrorRateModel ();
+
+  virtual double GetChunkSuccessRate (WifiMode mode, double snr, uint32_t nbits) const;
+
+private:
+  struct Table
+  {
+    std::vector<double> q;    // at ln (snr) = GetLnMin + i * GetStep
+    std::vector<double> lnQ;
+    std::vector<char> usable; // interval i passed the midpoint check
+  };
+
+  static double GetStep (void);  // of the table in ln (snr)
+  static double GetLnMin (void);
+  static double GetLnMax (void);
+
+  const Table &GetTable (WifiMode mode) const;
+  double GetQ (WifiMode mode, double lnSnr) const; // straight from NIST
+  static double Interpolate (const Table &table, uint32_t i, double frac);
+
+  Ptr<NistErrorRateModel> m_nist;
+};
+
+inline double
+TableErrorRateModel::GetStep (void)
+{
+  return 0.0125; // about 0.05 dB
+}
+
+inline double
+TableErrorRateModel::GetLnMin (void)
+{
+  return -1 * M_LN10; // -10 dB
+}
+
+inline double
+TableErrorRateModel::GetLnMax (void)
+{
+  return 5 * M_LN10; //  50 dB
+}
+
+inline TypeId
+TableErrorRateModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TableErrorRateModel")
+    .SetParent<ErrorRateModel> ()
+    .AddConstructor<TableErrorRateModel> ();
+  return tid;
+}
+
+inline
+TableErrorRateModel::TableErrorRateModel ()
+  : m_nist (CreateObject<NistErrorRateModel> ())
+{
+}
+
+inline double
+TableErrorRateModel::GetQ (WifiMode mode, double lnSnr) const
+{
+  return -log (m_nist->GetChunkSuccessRate (mode, exp (lnSnr), 1));
+}
+
+inline double
+TableErrorRateModel::Interpolate (const Table &table, uint32_t i, double frac)
+{
+  double a = table.q[i];
+  double b = table.q[i + 1];
+  if (a > 0 && b > 0)
+    {
+      return exp (table.lnQ[i] + frac * (table.lnQ[i + 1] - table.lnQ[i]));
+    }
+  return a + frac * (b - a); // q reaches 0 once NIST rounds 1 - pe to 1
+}
+
+inline const TableErrorRateModel::Table &
+TableErrorRateModel::GetTable (WifiMode mode) const
+{
+  static std::map<uint32_t, Table> tables; // per process, so every PHY shares them
+  std::map<uint32_t, Table>::iterator found = tables.find (mode.GetUid ());
+  if (found != tables.end ())
+    {
+      return found->second;
+    }
+
+  Table &table = tables[mode.GetUid ()];
+  uint32_t n = (uint32_t)((GetLnMax () - GetLnMin ()) / GetStep ()) + 1;
+  table.q.resize (n);
+  table.lnQ.resize (n);
+  table.usable.assign (n - 1, 0);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      table.q[i] = GetQ (mode, GetLnMin () + i * GetStep ());
+      table.lnQ[i] = log (table.q[i]);
+    }
+  for (uint32_t i = 0; i + 1 < n; i++)
+    {
+      if (table.q[i] == INFINITY || table.q[i + 1] == INFINITY)
+        {
+          continue; // NIST gives exactly 0 there
+        }
+      double exact = GetQ (mode, GetLnMin () + (i + 0.5) * GetStep ());
+      double error = fabs (Interpolate (table, i, 0.5) - exact);
+      table.usable[i] = error <= 1e-3 * exact || error <= 5e-9;
+    }
+  return table;
+}
+
+inline double
+TableErrorRateModel::GetChunkSuccessRate (WifiMode mode, double snr, uint32_t nbits) const
+{
+  double lnSnr = log (snr);
+  if (!(lnSnr >= GetLnMin () && lnSnr < GetLnMax () - GetStep ()))
+    {
+      return m_nist->GetChunkSuccessRate (mode, snr, nbits);
+    }
+  const Table &table = GetTable (mode);
+  double x = (lnSnr - GetLnMin ()) / GetStep ();
+  uint32_t i = (uint32_t)x;
+  if (!table.usable[i])
+    {
+      return m_nist->GetChunkSuccessRate (mode, snr, nbits);
+    }
+  return exp (-(double)nbits * Interpolate (table, i, x - i));
+}
+
+} // namespace ns3
+
+#endif /* ERROR_TABLE_H */
@@ -0,0 +1,224 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef GRID_CHANNEL_H
+#define GRID_CHANNEL_H
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/propagation-module.h"
+#include "ns3/wifi-module.h"
+
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <math.h>
+
+namespace ns3 {
+
+/*
+ * Takes the receivers a transmission can never reach out of the channel's
+ * delivery loop.  A YansWifiChannel schedules a reception, runs the loss
+ * chain and adds an interference event at every PHY it holds, for every
+ * frame, which is what makes cells of hundreds of stations O(N^2).
+ *
+ * YansWifiChannel::Send is not virtual and YansWifiPhy sends on whichever
+ * YansWifiChannel it was given last, so rather than replacing the loop
+ * this gives every PHY a channel of its own to send on.  That channel
+ * holds only the PHYs within range of it, found through a grid of cells
+ * one range wide, so each PHY looks at the nine cells around its own.
+ * The range is where the received power drops below floor dBm even with
+ * margin dB of fading above the LogDistance loss, at the highest transmit
+ * power and antenna gains of any PHY; keep the floor below every PHY's
+ * energy-detection and CCA thresholds so that a culled frame could never
+ * have been received or sensed.  All the channels share the original
+ * loss chain and delay model, so draws and cached losses are shared too.
+ *
+ * A receiver within range gets the same power, from the same chain, in
+ * the same order relative to the other receivers as from the shared
+ * channel.  What it loses are the events for culled frames, which only
+ * ever added to its interference sum, by at most the floor per frame:
+ * with the floor 30 dB under the noise floor (about -94 dBm for 802.11g)
+ * that is 0.1% of the noise per overlapping culled frame.  With fading,
+ * culled pairs no longer draw, which moves later draws along the stream,
+ * so results are statistically, not bitwise, those of the shared channel.
+ *
+ * The neighbourhoods are worked out once, from positions that must never
+ * change, so every node needs a ConstantPositionMobilityModel already
+ * placed when Install is called.
+ */
+class GridWifiChannelHelper
+{
+public:
+  GridWifiChannelHelper ();
+
+  void SetModels (Ptr<PropagationLossModel> loss, Ptr<PropagationDelayModel> delay);
+  void SetRange (Ptr<LogDistancePropagationLossModel> distance, double floor, double margin);
+  void Install (const NetDeviceContainer &devices);
+  uint64_t GetCulled (void) const;
+
+private:
+  typedef std::pair<int64_t, int64_t> Cell;
+
+  double GetRange (const std::vector<Ptr<YansWifiPhy> > &phys) const;
+  Cell GetCell (const Vector &position, double range) const;
+
+  Ptr<PropagationLossModel> m_loss;
+  Ptr<PropagationDelayModel> m_delay;
+  double m_floor;
+  double m_margin;
+  double m_exponent;
+  double m_referenceDistance;
+  double m_referenceLoss;
+  uint64_t m_culled; // (transmitter, receiver) pairs left out by the last Install
+};
+
+inline
+GridWifiChannelHelper::GridWifiChannelHelper ()
+  : m_floor (-1000.0),
+    m_margin (0.0),
+    m_exponent (3.0),
+    m_referenceDistance (1.0),
+    m_referenceLoss (46.6777),
+    m_culled (0)
+{
+}
+
+// the models of the shared channel, which every per-PHY channel uses as they are
+inline void
+GridWifiChannelHelper::SetModels (Ptr<PropagationLossModel> loss, Ptr<PropagationDelayModel> delay)
+{
+  m_loss = loss;
+  m_delay = delay;
+}
+
+// distance is the loss chain's distance stage, whose parameters set the range
+inline void
+GridWifiChannelHelper::SetRange (Ptr<LogDistancePropagationLossModel> distance, double floor, double margin)
+{
+  DoubleValue v;
+  distance->GetAttribute ("Exponent", v);
+  m_exponent = v.Get ();
+  distance->GetAttribute ("ReferenceDistance", v);
+  m_referenceDistance = v.Get ();
+  distance->GetAttribute ("ReferenceLoss", v);
+  m_referenceLoss = v.Get ();
+  m_floor = floor;
+  m_margin = margin;
+}
+
+inline uint64_t
+GridWifiChannelHelper::GetCulled (void) const
+{
+  return m_culled;
+}
+
+inline double
+GridWifiChannelHelper::GetRange (const std::vector<Ptr<YansWifiPhy> > &phys) const
+{
+  double txPower = -1000.0;
+  double rxGain = -1000.0;
+  for (uint32_t i = 0; i < phys.size (); i++)
+    {
+      txPower = std::max (txPower, phys[i]->GetTxPowerEnd () + phys[i]->GetTxGain ());
+      rxGain = std::max (rxGain, phys[i]->GetRxGain ());
+    }
+  // rx = tx - L0 - 10 n log10 (d / d0) drops below floor - margin beyond this distance;
+  // LogDistance takes nothing off within d0, so nothing closer can ever be culled
+  double range = m_referenceDistance
+    * pow (10.0, (txPower + rxGain + m_margin - m_referenceLoss - m_floor) / (10 * m_exponent));
+  return std::max (range, m_referenceDistance);
+}
+
+inline GridWifiChannelHelper::Cell
+GridWifiChannelHelper::GetCell (const Vector &position, double range) const
+{
+  return Cell ((int64_t)floor (position.x / range), (int64_t)floor (position.y / range));
+}
+
+inline void
+GridWifiChannelHelper::Install (const NetDeviceContainer &devices)
+{
+  NS_ABORT_MSG_UNLESS (m_loss && m_delay, "GridWifiChannelHelper: SetModels before Install");
+  std::vector<Ptr<YansWifiPhy> > phys;
+  std::vector<Vector> positions;
+  for (uint32_t i = 0; i < devices.GetN (); i++)
+    {
+      Ptr<WifiNetDevice> device = DynamicCast<WifiNetDevice> (devices.Get (i));
+      NS_ABORT_MSG_UNLESS (device, "GridWifiChannelHelper: device " << i << " is not a WifiNetDevice");
+      Ptr<YansWifiPhy> phy = DynamicCast<YansWifiPhy> (device->GetPhy ());
+      NS_ABORT_MSG_UNLESS (phy, "GridWifiChannelHelper: device " << i << " has no YansWifiPhy");
+      Ptr<MobilityModel> mobility = device->GetNode ()->GetObject<MobilityModel> ();
+      NS_ABORT_MSG_UNLESS (DynamicCast<ConstantPositionMobilityModel> (mobility),
+                           "GridWifiChannelHelper: node " << device->GetNode ()->GetId () << " can move");
+      phys.push_back (phy);
+      positions.push_back (mobility->GetPosition ());
+    }
+
+  double range = GetRange (phys);
+  double range2 = range * range;
+  std::map<Cell, std::vector<uint32_t> > grid; // indices ascending within each cell
+  for (uint32_t i = 0; i < positions.size (); i++)
+    {
+      grid[GetCell (positions[i], range)].push_back (i);
+    }
+
+  m_culled = 0;
+  for (uint32_t i = 0; i < phys.size (); i++)
+    {
+      std::vector<uint32_t> neighbours;
+      Cell home = GetCell (positions[i], range);
+      for (int64_t cx = home.first - 1; cx <= home.first + 1; cx++)
+        {
+          for (int64_t cy = home.second - 1; cy <= home.second + 1; cy++)
+            {
+              std::map<Cell, std::vector<uint32_t> >::const_iterator cell = grid.find (Cell (cx, cy));
+              if (cell == grid.end ())
+                {
+                  continue;
+                }
+              for (uint32_t k = 0; k < cell->second.size (); k++)
+                {
+                  uint32_t j = cell->second[k];
+                  double dx = positions[i].x - positions[j].x;
+                  double dy = positions[i].y - positions[j].y;
+                  double dz = positions[i].z - positions[j].z;
+                  if (j != i && dx * dx + dy * dy + dz * dz <= range2)
+                    {
+                      neighbours.push_back (j);
+                    }
+                }
+            }
+        }
+      std::sort (neighbours.begin (), neighbours.end ()); //receptions get scheduled in the shared channel's order
+      m_culled += phys.size () - 1 - neighbours.size ();
+
+      Ptr<YansWifiChannel> own = CreateObject<YansWifiChannel> ();
+      own->SetPropagationLossModel (m_loss);
+      own->SetPropagationDelayModel (m_delay);
+      phys[i]->SetChannel (own); //from now on it sends here; the sender itself is never delivered to
+      for (uint32_t k = 0; k < neighbours.size (); k++)
+        {
+          own->Add (phys[neighbours[k]]);
+        }
+    }
+}
+
+} // namespace ns3
+
+#endif /* GRID_CHANNEL_H */
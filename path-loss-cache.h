@@ -0,0 +1,213 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef PATH_LOSS_CACHE_H
+#define PATH_LOSS_CACHE_H
+
+#include "ns3/core-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/propagation-module.h"
+
+#include <vector>
+#include <math.h>
+#include <stdint.h>
+
+namespace ns3 {
+
+/*
+ * Memoizes a deterministic loss model for nodes that never move.  The
+ * first time a pair is seen, the model's gain (CalcRxPower at 0 dBm) goes
+ * into a dense matrix indexed by the order the two mobility models were
+ * first seen in; afterwards the pair costs two lookups in a flat hash table
+ * from model to index and one matrix read.  (The node id would need
+ * GetObject<Node> on the mobility model, which walks the aggregate list
+ * that YansWifiChannel::Send has just reordered to find the model.)  The fading
+ * stage, if any, still runs on every frame on top of the cached power.
+ *
+ * Only ConstantPositionMobilityModel positions are cached, since that is
+ * the only model whose position changes always fire CourseChange; a
+ * CourseChange clears the node's row and column.  Other mobility models
+ * go straight to the deterministic model every time.
+ *
+ * LogDistancePropagationLossModel returns txPowerDbm + gain, so adding the
+ * cached gain gives bit for bit the same power as the uncached chain.
+ */
+class CachingPropagationLossModel : public PropagationLossModel
+{
+public:
+  static TypeId GetTypeId (void);
+
+  CachingPropagationLossModel ();
+
+  void SetModels (Ptr<PropagationLossModel> deterministic, Ptr<PropagationLossModel> fading);
+
+private:
+  virtual double DoCalcRxPower (double txPowerDbm, Ptr<MobilityModel> a, Ptr<MobilityModel> b) const;
+  virtual int64_t DoAssignStreams (int64_t stream);
+
+  struct Slot
+  {
+    const MobilityModel *model; // 0 = free
+    uint32_t index;             // -1 if the model cannot be cached
+  };
+
+  uint32_t FindSlot (const MobilityModel *model) const;
+  uint32_t GetIndex (Ptr<MobilityModel> model) const; // -1 if the model cannot be cached
+  void CourseChanged (Ptr<const MobilityModel> model);
+
+  Ptr<PropagationLossModel> m_deterministic;
+  Ptr<PropagationLossModel> m_fading;
+  mutable std::vector<Slot> m_slots; // open addressing, a power of two long, at most half full
+  mutable uint32_t m_models;    // slots in use
+  mutable uint32_t m_cached;    // cacheable models, which take indices 0..m_cached-1
+  mutable uint32_t m_size;      // matrix is m_size x m_size
+  mutable std::vector<double> m_gain; // row = transmitter, NAN = not computed yet
+};
+
+inline TypeId
+CachingPropagationLossModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::CachingPropagationLossModel")
+    .SetParent<PropagationLossModel> ()
+    .AddConstructor<CachingPropagationLossModel> ();
+  return tid;
+}
+
+inline
+CachingPropagationLossModel::CachingPropagationLossModel ()
+  : m_models (0),
+    m_cached (0),
+    m_size (0)
+{
+  Slot empty = { 0, 0 };
+  m_slots.resize (64, empty);
+}
+
+inline void
+CachingPropagationLossModel::SetModels (Ptr<PropagationLossModel> deterministic, Ptr<PropagationLossModel> fading)
+{
+  m_deterministic = deterministic;
+  m_fading = fading;
+}
+
+// the slot holding model, or the free slot where it belongs
+inline uint32_t
+CachingPropagationLossModel::FindSlot (const MobilityModel *model) const
+{
+  uint32_t mask = m_slots.size () - 1;
+  uint32_t i = (uint32_t)(((uint64_t)(uintptr_t)model * 0x9e3779b97f4a7c15ULL) >> 32) & mask; // Fibonacci hashing
+  while (m_slots[i].model != 0 && m_slots[i].model != model)
+    {
+      i = (i + 1) & mask;
+    }
+  return i;
+}
+
+inline uint32_t
+CachingPropagationLossModel::GetIndex (Ptr<MobilityModel> model) const
+{
+  uint32_t slot = FindSlot (PeekPointer (model));
+  if (m_slots[slot].model != 0)
+    {
+      return m_slots[slot].index;
+    }
+  uint32_t index = -1;
+  if (DynamicCast<ConstantPositionMobilityModel> (model))
+    {
+      index = m_cached++;
+      model->TraceConnectWithoutContext ("CourseChange",
+                                         MakeCallback (&CachingPropagationLossModel::CourseChanged,
+                                                       const_cast<CachingPropagationLossModel *> (this)));
+    }
+  m_slots[slot].model = PeekPointer (model);
+  m_slots[slot].index = index;
+  if (2 * ++m_models > m_slots.size ())
+    {
+      std::vector<Slot> slots;
+      slots.swap (m_slots);
+      Slot empty = { 0, 0 };
+      m_slots.resize (2 * slots.size (), empty);
+      for (uint32_t k = 0; k < slots.size (); k++)
+        {
+          if (slots[k].model != 0)
+            {
+              m_slots[FindSlot (slots[k].model)] = slots[k];
+            }
+        }
+    }
+
+  if (index != (uint32_t)-1 && index >= m_size)
+    {
+      uint32_t size = m_size ? 2 * m_size : 64;
+      std::vector<double> gain (size * size, NAN);
+      for (uint32_t tx = 0; tx < m_size; tx++)
+        {
+          std::copy (m_gain.begin () + tx * m_size, m_gain.begin () + (tx + 1) * m_size, gain.begin () + tx * size);
+        }
+      m_gain.swap (gain);
+      m_size = size;
+    }
+  return index;
+}
+
+inline void
+CachingPropagationLossModel::CourseChanged (Ptr<const MobilityModel> model)
+{
+  const Slot &slot = m_slots[FindSlot (PeekPointer (model))];
+  if (slot.model == 0 || slot.index == (uint32_t)-1)
+    {
+      return;
+    }
+  for (uint32_t k = 0; k < m_size; k++)
+    {
+      m_gain[slot.index * m_size + k] = NAN;
+      m_gain[k * m_size + slot.index] = NAN;
+    }
+}
+
+inline double
+CachingPropagationLossModel::DoCalcRxPower (double txPowerDbm, Ptr<MobilityModel> a, Ptr<MobilityModel> b) const
+{
+  uint32_t tx = GetIndex (a);
+  uint32_t rx = GetIndex (b);
+  double rxPowerDbm;
+  if (tx == (uint32_t)-1 || rx == (uint32_t)-1)
+    {
+      rxPowerDbm = m_deterministic->CalcRxPower (txPowerDbm, a, b);
+    }
+  else
+    {
+      double &gain = m_gain[tx * m_size + rx];
+      if (gain != gain) // NAN: not computed yet
+        {
+          gain = m_deterministic->CalcRxPower (0.0, a, b);
+        }
+      rxPowerDbm = txPowerDbm + gain;
+    }
+  return m_fading ? m_fading->CalcRxPower (rxPowerDbm, a, b) : rxPowerDbm;
+}
+
+inline int64_t
+CachingPropagationLossModel::DoAssignStreams (int64_t stream)
+{
+  int64_t n = m_deterministic->AssignStreams (stream);
+  return m_fading ? n + m_fading->AssignStreams (stream + n) : n;
+}
+
+} // namespace ns3
+
+#endif /* PATH_LOSS_CACHE_H */
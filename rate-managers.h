@@ -0,0 +1,141 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef RATE_MANAGERS_H
+#define RATE_MANAGERS_H
+
+#include "ns3/core-module.h"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <utility>
+
+namespace ns3 {
+
+/*
+ * The rate managers a trial's "manager" names: a registered short name,
+ * optionally followed by attributes in ns-3's own syntax, as in
+ * "minstrel[LookAroundRate=20|EWMA=90]", or the TypeId name of any other
+ * ns3::...WifiManager.  "constant-<Mb/s>" is ConstantRateWifiManager
+ * fixed at one of 802.11g's rates, which maps out the throughput each
+ * rate can reach at each distance.  In a sweep's manager list, "adaptive"
+ * and "constant" stand for all registered managers of either kind.
+ */
+struct RateManager
+{
+  std::string type;
+  std::vector<std::pair<std::string, std::string> > attributes; // name, value
+};
+
+inline const std::map<std::string, RateManager> &
+GetRateManagers (void)
+{
+  static std::map<std::string, RateManager> managers;
+  if (managers.empty ())
+    {
+      static const char *const adaptive[][2] = {
+        { "aarf", "ns3::AarfWifiManager" },
+        { "aarfcd", "ns3::AarfcdWifiManager" },
+        { "amrr", "ns3::AmrrWifiManager" },
+        { "arf", "ns3::ArfWifiManager" },
+        { "cara", "ns3::CaraWifiManager" },
+        { "ideal", "ns3::IdealWifiManager" },
+        { "minstrel", "ns3::MinstrelWifiManager" },
+        { "onoe", "ns3::OnoeWifiManager" },
+        { "rraa", "ns3::RraaWifiManager" }
+      };
+      for (uint32_t i = 0; i < sizeof (adaptive) / sizeof (adaptive[0]); i++)
+        {
+          managers[adaptive[i][0]].type = adaptive[i][1];
+        }
+      static const char *const rates[][2] = { // 802.11g: DSSS/CCK, then ERP-OFDM
+        { "1", "DsssRate1Mbps" }, { "2", "DsssRate2Mbps" }, { "5.5", "DsssRate5_5Mbps" }, { "11", "DsssRate11Mbps" },
+        { "6", "ErpOfdmRate6Mbps" }, { "9", "ErpOfdmRate9Mbps" }, { "12", "ErpOfdmRate12Mbps" },
+        { "18", "ErpOfdmRate18Mbps" }, { "24", "ErpOfdmRate24Mbps" }, { "36", "ErpOfdmRate36Mbps" },
+        { "48", "ErpOfdmRate48Mbps" }, { "54", "ErpOfdmRate54Mbps" }
+      };
+      for (uint32_t i = 0; i < sizeof (rates) / sizeof (rates[0]); i++)
+        {
+          RateManager &m = managers[std::string ("constant-") + rates[i][0]];
+          m.type = "ns3::ConstantRateWifiManager";
+          m.attributes.push_back (std::make_pair ("DataMode", rates[i][1]));
+          m.attributes.push_back (std::make_pair ("ControlMode", rates[i][1])); // RTS at the data rate too
+        }
+    }
+  return managers;
+}
+
+// the registered names of one kind, for "adaptive" and "constant" in sweep lists
+inline std::vector<std::string>
+GetRateManagerNames (bool constant)
+{
+  std::vector<std::string> names;
+  const std::map<std::string, RateManager> &managers = GetRateManagers ();
+  for (std::map<std::string, RateManager>::const_iterator i = managers.begin (); i != managers.end (); ++i)
+    {
+      if ((i->second.type == "ns3::ConstantRateWifiManager") == constant)
+        {
+          names.push_back (i->first);
+        }
+    }
+  return names;
+}
+
+inline RateManager
+GetRateManager (const std::string &manager)
+{
+  std::string::size_type open = manager.find ('[');
+  std::string name = manager.substr (0, open);
+  RateManager m;
+  std::map<std::string, RateManager>::const_iterator i = GetRateManagers ().find (name);
+  if (i != GetRateManagers ().end ())
+    {
+      m = i->second;
+    }
+  else
+    {
+      NS_ABORT_MSG_UNLESS (name.compare (0, 5, "ns3::") == 0, "unknown rate manager \"" << name << "\"");
+      m.type = name;
+    }
+  if (open == std::string::npos)
+    {
+      return m;
+    }
+  NS_ABORT_MSG_UNLESS (manager[manager.size () - 1] == ']', "rate manager attributes should read name[a=x|b=y], got \"" << manager << "\"");
+  std::string list = manager.substr (open + 1, manager.size () - open - 2);
+  std::string::size_type start = 0;
+  while (start <= list.size ())
+    {
+      std::string::size_type bar = list.find ('|', start);
+      std::string item = list.substr (start, bar == std::string::npos ? std::string::npos : bar - start);
+      std::string::size_type eq = item.find ('=');
+      NS_ABORT_MSG_IF (eq == std::string::npos || eq == 0, "bad rate manager attribute \"" << item << "\" in \"" << manager << "\"");
+      m.attributes.push_back (std::make_pair (item.substr (0, eq), item.substr (eq + 1)));
+      if (bar == std::string::npos)
+        {
+          break;
+        }
+      start = bar + 1;
+    }
+  NS_ABORT_MSG_IF (m.attributes.size () > 8, "at most 8 rate manager attributes, got \"" << manager << "\"");
+  return m;
+}
+
+} // namespace ns3
+
+#endif /* RATE_MANAGERS_H */
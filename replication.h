@@ -0,0 +1,183 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef REPLICATION_H
+#define REPLICATION_H
+
+#include <stdint.h>
+#include <math.h>
+
+namespace ns3 {
+
+// inverse standard normal CDF (Acklam's rational approximation, |error| < 1.2e-9)
+inline double
+NormalQuantile (double p)
+{
+  static const double a[] = { -3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02,
+                              1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00 };
+  static const double b[] = { -5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02,
+                              6.680131188771972e+01, -1.328068155288572e+01 };
+  static const double c[] = { -7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00,
+                              -2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00 };
+  static const double d[] = { 7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00,
+                              3.754408661907416e+00 };
+  if (p < 0.02425)
+    {
+      double q = sqrt (-2 * log (p));
+      return (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5])
+             / ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1);
+    }
+  if (p > 1 - 0.02425)
+    {
+      return -NormalQuantile (1 - p);
+    }
+  double q = p - 0.5;
+  double r = q * q;
+  return (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q
+         / (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1);
+}
+
+/*
+ * Quantile of Student's t with df degrees of freedom: exact for df 1 and 2,
+ * the Cornish-Fisher expansion (Abramowitz & Stegun 26.7.5) otherwise,
+ * which is within 1% of the tabled values from df = 3 up for 95-99%
+ * intervals, and much closer as df grows.
+ */
+inline double
+StudentTQuantile (double p, uint32_t df)
+{
+  if (df == 1)
+    {
+      return tan (M_PI * (p - 0.5));
+    }
+  if (df == 2)
+    {
+      return (2 * p - 1) / sqrt (2 * p * (1 - p));
+    }
+  double z = NormalQuantile (p);
+  double z2 = z * z;
+  double v = df;
+  double g1 = (z2 + 1) * z / 4;
+  double g2 = ((5 * z2 + 16) * z2 + 3) * z / 96;
+  double g3 = (((3 * z2 + 19) * z2 + 17) * z2 - 15) * z / 384;
+  double g4 = ((((79 * z2 + 776) * z2 + 1482) * z2 - 1920) * z2 - 945) * z / 92160;
+  return z + g1 / v + g2 / (v * v) + g3 / (v * v * v) + g4 / (v * v * v * v);
+}
+
+/*
+ * Running summary of the replications of one sweep point.  The mean is
+ * kept as sum / n so that it matches the plain averages the drivers
+ * always printed; the variance uses Welford's update.
+ */
+class ReplicationStats
+{
+public:
+  ReplicationStats ();
+
+  void Add (double x);
+
+  uint32_t GetN (void) const;
+  double GetMean (void) const;
+  double GetStdDev (void) const;
+  double GetHalfWidth (double confidence) const;
+
+  /*
+   * How many replications in total this point needs for a confidence
+   * interval half-width of at most target * |mean|, given the variance
+   * seen so far; never less than n, and n + 1 while the interval is
+   * still too wide.
+   */
+  uint32_t GetWanted (double target, double confidence) const;
+
+private:
+  uint32_t m_n;
+  double m_sum;
+  double m_mean;
+  double m_m2;
+};
+
+inline
+ReplicationStats::ReplicationStats ()
+  : m_n (0),
+    m_sum (0.0),
+    m_mean (0.0),
+    m_m2 (0.0)
+{
+}
+
+inline void
+ReplicationStats::Add (double x)
+{
+  m_n++;
+  m_sum += x;
+  double delta = x - m_mean;
+  m_mean += delta / m_n;
+  m_m2 += delta * (x - m_mean);
+}
+
+inline uint32_t
+ReplicationStats::GetN (void) const
+{
+  return m_n;
+}
+
+inline double
+ReplicationStats::GetMean (void) const
+{
+  return m_n ? m_sum / (double)m_n : 0.0;
+}
+
+inline double
+ReplicationStats::GetStdDev (void) const
+{
+  return m_n > 1 ? sqrt (m_m2 / (m_n - 1)) : 0.0;
+}
+
+inline double
+ReplicationStats::GetHalfWidth (double confidence) const
+{
+  if (m_n < 2)
+    {
+      return INFINITY;
+    }
+  return StudentTQuantile (0.5 + confidence / 2, m_n - 1) * GetStdDev () / sqrt ((double)m_n);
+}
+
+inline uint32_t
+ReplicationStats::GetWanted (double target, double confidence) const
+{
+  double halfWidth = GetHalfWidth (confidence);
+  double allowed = target * fabs (GetMean ());
+  if (halfWidth <= allowed)
+    {
+      return m_n;
+    }
+  if (m_n < 2 || allowed == 0)
+    {
+      return m_n + 1;
+    }
+  double ratio = halfWidth / allowed;
+  double wanted = ceil (m_n * ratio * ratio);
+  if (wanted >= 1e9)
+    {
+      return 1000000000; // the caller caps this at max-reps anyway
+    }
+  return wanted > m_n ? (uint32_t)wanted : m_n + 1;
+}
+
+} // namespace ns3
+
+#endif /* REPLICATION_H */
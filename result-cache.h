@@ -0,0 +1,239 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include "ns3/core-module.h"
+
+#include "scenario.h"
+
+#include <string>
+#include <map>
+#include <fstream>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+// bump whenever a change to trial.h changes what a given TrialSpec produces
+#define SWEEP_CACHE_FORMAT "7"
+
+namespace ns3 {
+
+inline uint64_t
+HashString (const std::string &s) // 64-bit FNV-1a
+{
+  uint64_t h = 14695981039346656037ULL;
+  for (std::string::size_type i = 0; i < s.size (); i++)
+    {
+      h ^= (unsigned char)s[i];
+      h *= 1099511628211ULL;
+    }
+  return h;
+}
+
+inline std::string
+FormatHash (uint64_t h)
+{
+  char buf[17];
+  snprintf (buf, sizeof (buf), "%016llx", (unsigned long long)h);
+  return buf;
+}
+
+/*
+ * The ns-3 release the drivers were built against, which goes into every
+ * cache key so that results from different releases never mix.  ns-3.19
+ * has no version header, so it has to be given: at run time with
+ * --ns3-version (SetNs3Version), or once in the build, e.g.
+ *
+ *   CXXFLAGS='-DSWEEP_NS3_VERSION=\"ns-3.19\"' ./waf configure
+ *
+ * There is deliberately no fallback: a guessed version would silently
+ * share cache entries between releases.
+ */
+inline std::string &
+Ns3Version (void)
+{
+#ifdef SWEEP_NS3_VERSION
+  static std::string version = SWEEP_NS3_VERSION;
+#else
+  static std::string version;
+#endif
+  return version;
+}
+
+inline void
+SetNs3Version (const std::string &version)
+{
+  Ns3Version () = version;
+}
+
+inline std::string
+GetNs3Version (void)
+{
+  NS_ABORT_MSG_IF (Ns3Version ().empty (), "the ns-3 version is unknown: pass --ns3-version=ns-3.x (see result-cache.h)");
+  return Ns3Version ();
+}
+
+/*
+ * Trial results persisted in <dir>/results.log (or another file in dir,
+ * as the shards of a sharded sweep each use their own), keyed by a hash of the
+ * trial's full canonical spec plus the ns-3 version and cache format.
+ *
+ * The log is only ever appended to, one line per result:
+ *
+ *   <hash> \t <canonical spec> \t <result> \t <checksum> \n
+ *
+ * Each line goes out in a single write() on an O_APPEND descriptor, so
+ * concurrent writers (the pool's children) never interleave, and a line
+ * cut short by a crash fails its checksum and is ignored on the next load,
+ * which also terminates it so that later records stay intact.
+ * Resuming an interrupted sweep is just rerunning it with the same cache.
+ */
+class ResultCache
+{
+public:
+  ResultCache (const std::string &dir, const std::string &file = "results.log");
+
+  bool Lookup (const TrialSpec &spec, std::string &result) const;
+  void Store (const TrialSpec &spec, const std::string &result);
+  void Remember (const TrialSpec &spec, const std::string &result);
+  uint32_t GetSize (void) const;
+
+  static std::string GetCanonicalKey (const TrialSpec &spec);
+
+private:
+  void Load (void);
+  void AppendLine (const std::string &line);
+
+  std::string m_path;
+  std::map<std::string, std::pair<std::string, std::string> > m_entries; // hash -> (key, result)
+};
+
+inline
+ResultCache::ResultCache (const std::string &dir, const std::string &file)
+  : m_path (dir + "/" + file)
+{
+  GetNs3Version (); // fail before any trial runs, not at its first Store
+  if (mkdir (dir.c_str (), 0755) < 0 && errno != EEXIST)
+    {
+      NS_FATAL_ERROR ("cannot create cache directory \"" << dir << "\": " << strerror (errno));
+    }
+  Load ();
+}
+
+inline std::string
+ResultCache::GetCanonicalKey (const TrialSpec &spec)
+{
+  return spec.ToString () + " ns3=" + GetNs3Version () + " format=" + SWEEP_CACHE_FORMAT;
+}
+
+inline void
+ResultCache::Load (void)
+{
+  std::ifstream in (m_path.c_str ());
+  std::string line;
+  bool terminated = true;
+  while (std::getline (in, line))
+    {
+      terminated = !in.eof ();
+      std::string::size_type last = line.rfind ('\t');
+      if (last == std::string::npos
+          || FormatHash (HashString (line.substr (0, last))) != line.substr (last + 1))
+        {
+          continue;
+        }
+      std::string::size_type t1 = line.find ('\t');
+      std::string::size_type t2 = line.find ('\t', t1 + 1);
+      if (t2 == std::string::npos || t2 >= last)
+        {
+          continue;
+        }
+      m_entries[line.substr (0, t1)] = std::make_pair (line.substr (t1 + 1, t2 - t1 - 1),
+                                                       line.substr (t2 + 1, last - t2 - 1));
+    }
+  if (!terminated)
+    {
+      AppendLine ("\n"); // end the torn line so the next record starts on a line of its own
+    }
+}
+
+inline void
+ResultCache::AppendLine (const std::string &line)
+{
+  int fd = open (m_path.c_str (), O_WRONLY | O_APPEND | O_CREAT, 0644);
+  if (fd < 0)
+    {
+      NS_FATAL_ERROR ("cannot open \"" << m_path << "\": " << strerror (errno));
+    }
+  ssize_t n;
+  do
+    {
+      n = write (fd, line.data (), line.size ());
+    }
+  while (n < 0 && errno == EINTR);
+  if (n != (ssize_t)line.size ())
+    {
+      NS_FATAL_ERROR ("short write to \"" << m_path << "\"");
+    }
+  close (fd);
+}
+
+inline bool
+ResultCache::Lookup (const TrialSpec &spec, std::string &result) const
+{
+  std::string key = GetCanonicalKey (spec);
+  std::map<std::string, std::pair<std::string, std::string> >::const_iterator i =
+    m_entries.find (FormatHash (HashString (key)));
+  if (i == m_entries.end () || i->second.first != key)
+    {
+      return false;
+    }
+  result = i->second.second;
+  return true;
+}
+
+inline void
+ResultCache::Remember (const TrialSpec &spec, const std::string &result)
+{
+  std::string key = GetCanonicalKey (spec);
+  m_entries[FormatHash (HashString (key))] = std::make_pair (key, result);
+}
+
+inline void
+ResultCache::Store (const TrialSpec &spec, const std::string &result)
+{
+  NS_ABORT_MSG_IF (result.find_first_of ("\t\n") != std::string::npos, "trial result must be a single tab-free line");
+  std::string key = GetCanonicalKey (spec);
+  std::string line = FormatHash (HashString (key)) + "\t" + key + "\t" + result;
+  line += "\t" + FormatHash (HashString (line)) + "\n";
+  AppendLine (line);
+  Remember (spec, result);
+}
+
+inline uint32_t
+ResultCache::GetSize (void) const
+{
+  return m_entries.size ();
+}
+
+} // namespace ns3
+
+#endif /* RESULT_CACHE_H */
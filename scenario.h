@@ -0,0 +1,887 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include "ns3/core-module.h"
+
+#include "rate-managers.h"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <ctype.h>
+
+namespace ns3 {
+
+/*
+ * Everything needed to rebuild one simulation: an AP with "stations"
+ * stations around it, each with one CBR flow to or from the AP.
+ *
+ * placement "line" puts station i at (i+1)*distance metres from the AP along
+ * the x axis (with one station, that is part1's two-node world); "disc" puts
+ * the stations at random on a disc around the AP with a radius uniform on
+ * [rho-min, rho-max] (part2 used 10..10, part3 0..25).  "stratified" draws
+ * from the same disc with one radius ring and one angle sector per
+ * station, and "antithetic" also mirrors the layout of each odd run in
+ * the next even one (see stratified-placement.h); both cut the
+ * seed-to-seed spread that comes from where the stations land.  A sweep
+ * always runs antithetic points in whole pairs of runs (see SweepSpec).
+ *
+ * manager is a rate manager by the names rate-managers.h registers
+ * (aarf, cara, minstrel, constant-54, ...), with optional attributes.
+ *
+ * direction says who sends each flow: "uplink" (the stations), "downlink"
+ * (the AP), "random" (a coin per flow from the trial's own stream), or a
+ * fraction such as 0.25 of downlink flows spread evenly over the stations.
+ *
+ * Throughput is measured per flow over the flow's own receive span, from
+ * its first to its last received packet.  Setting measure-to (and
+ * optionally measure-from) measures every flow over that fixed window of
+ * simulated seconds instead.  Setting sample instead measures steady-state
+ * throughput in windows of that many seconds after a warm-up of
+ * measure-from seconds, and ends the trial as soon as the estimate is
+ * within steady-tol of converged (see steady-state.h); duration is then
+ * only an upper bound.  Delay and jitter percentiles come from
+ * FlowMonitor's histograms, binned at delay-bin seconds, by default
+ * FlowMonitor's own 1 ms.  FlowMonitor keeps those histograms dense, one
+ * counter per bin up to the longest delay or jitter seen, so each flow's
+ * memory grows with that longest delay over delay-bin, not with its
+ * packets: at 1 ms a flow whose worst delay is 2 s holds 2000 bins of
+ * each.  Finer bins resolve short delays better at that price.
+ *
+ * cull, when not "off", is a received-power floor in dBm: each device then
+ * sends on a channel of its own that leaves out every receiver too far
+ * away to ever get above the floor (see grid-channel.h).  That is not
+ * result-neutral, as culled frames no longer add to anyone's interference,
+ * so every result reports how many links its floor removed ("culled").
+ * fading-model and error-model pick faster implementations of the same
+ * models (block-fading.h, error-table.h) at the price of not reproducing
+ * the default ones' results bit for bit.
+ *
+ * The spec is also written and read as one line of space separated
+ * key=value pairs, which is what --trial takes and what later tooling keys
+ * results on.
+ */
+struct TrialSpec
+{
+  TrialSpec ();
+
+  void Set (const std::string &key, const std::string &value);
+  std::string Get (const std::string &key) const;
+  std::string ToString (void) const;
+  std::string GetPointKey (void) const; // ToString without the replication keys
+
+  static TrialSpec Parse (const std::string &line);
+  static const std::vector<std::string> &GetKeys (void);
+  static bool IsReplicationKey (const std::string &key);
+
+  std::string manager;   // a rate manager as rate-managers.h names them, e.g. "aarf", "constant-54"
+  std::string fading;    // "none" or "rayleigh"
+  std::string fadingModel; // how rayleigh fading is drawn: "nakagami" or "block" (block-fading.h)
+  std::string cull;      // "off" or a floor in dBm
+  std::string errorModel; // "nist" or "table" (error-table.h)
+  std::string placement; // "line", "disc", "stratified" or "antithetic"
+  std::string dataRate;
+  uint32_t packetSize;
+  double duration;       // seconds of traffic
+  double measureFrom;    // measurement window, seconds; measureTo == 0 uses each flow's receive span
+  double measureTo;
+  double sample;         // steady-state window, seconds; 0 disables steady-state detection
+  double steadyTol;      // relative CI half-width at which the steady-state estimate counts as converged
+  double delayBin;       // FlowMonitor delay and jitter histogram bin width, seconds
+  double rhoMin;
+  double rhoMax;
+  std::string direction; // "uplink", "downlink", "random", or the fraction of flows that are downlink
+  uint32_t stations;
+  double distance;
+  uint32_t seed;
+  uint32_t run;
+};
+
+inline std::string
+FormatNumber (double value)
+{
+  char buf[32];
+  snprintf (buf, sizeof (buf), "%.15g", value);
+  return buf;
+}
+
+inline double
+ParseNumber (const std::string &key, const std::string &value)
+{
+  char *end = 0;
+  double d = strtod (value.c_str (), &end);
+  if (value.empty () || *end != '\0')
+    {
+      NS_FATAL_ERROR ("\"" << key << "\" expects a number, got \"" << value << "\"");
+    }
+  return d;
+}
+
+inline std::string
+Trim (const std::string &s)
+{
+  std::string::size_type b = s.find_first_not_of (" \t\r\n");
+  if (b == std::string::npos)
+    {
+      return "";
+    }
+  std::string::size_type e = s.find_last_not_of (" \t\r\n");
+  return s.substr (b, e - b + 1);
+}
+
+inline
+TrialSpec::TrialSpec ()
+  : manager ("aarf"),
+    fading ("none"),
+    fadingModel ("nakagami"),
+    cull ("off"),
+    errorModel ("nist"),
+    placement ("line"),
+    dataRate ("20Mib/s"),
+    packetSize (1024),
+    duration (10.0),
+    measureFrom (0.0),
+    measureTo (0.0),
+    sample (0.0),
+    steadyTol (0.01),
+    delayBin (0.001),
+    rhoMin (10.0),
+    rhoMax (10.0),
+    direction ("uplink"),
+    stations (1),
+    distance (5.0),
+    seed (2),
+    run (1)
+{
+}
+
+// keys in expansion order, outermost first; the replication keys come last
+inline const std::vector<std::string> &
+TrialSpec::GetKeys (void)
+{
+  static const char *const names[] = {
+    "manager", "fading", "fading-model", "cull", "error-model", "placement", "data-rate", "packet-size", "duration",
+    "measure-from", "measure-to", "sample", "steady-tol", "delay-bin", "rho-min", "rho-max", "direction", "stations", "distance", "seed", "run"
+  };
+  static const std::vector<std::string> keys (names, names + sizeof (names) / sizeof (names[0]));
+  return keys;
+}
+
+inline bool
+TrialSpec::IsReplicationKey (const std::string &key)
+{
+  return key == "seed" || key == "run";
+}
+
+inline void
+TrialSpec::Set (const std::string &key, const std::string &value)
+{
+  if (key == "manager")
+    {
+      GetRateManager (value); // reject unknown names and bad attribute lists now
+      manager = value;
+    }
+  else if (key == "fading")
+    {
+      NS_ABORT_MSG_IF (value.compare (0, 8, "nakagami") == 0,
+                       "fading \"" << value << "\": only rayleigh, nakagami with m = 1, is modelled");
+      NS_ABORT_MSG_UNLESS (value == "none" || value == "rayleigh", "unknown fading \"" << value << "\"");
+      fading = value;
+    }
+  else if (key == "fading-model")
+    {
+      NS_ABORT_MSG_UNLESS (value == "nakagami" || value == "block", "unknown fading model \"" << value << "\"");
+      fadingModel = value;
+    }
+  else if (key == "cull")
+    {
+      if (value != "off")
+        {
+          ParseNumber (key, value);
+        }
+      cull = value;
+    }
+  else if (key == "error-model")
+    {
+      NS_ABORT_MSG_UNLESS (value == "nist" || value == "table", "unknown error model \"" << value << "\"");
+      errorModel = value;
+    }
+  else if (key == "placement")
+    {
+      NS_ABORT_MSG_UNLESS (value == "line" || value == "disc" || value == "stratified" || value == "antithetic",
+                           "unknown placement \"" << value << "\"");
+      NS_ABORT_MSG_IF (value == "antithetic" && run == 0, "antithetic placement pairs runs 2k-1 and 2k; run 0 has no partner");
+      placement = value;
+    }
+  else if (key == "data-rate")
+    {
+      dataRate = value;
+    }
+  else if (key == "packet-size")
+    {
+      packetSize = ParseNumber (key, value);
+    }
+  else if (key == "duration")
+    {
+      duration = ParseNumber (key, value);
+    }
+  else if (key == "measure-from")
+    {
+      measureFrom = ParseNumber (key, value);
+    }
+  else if (key == "measure-to")
+    {
+      measureTo = ParseNumber (key, value);
+    }
+  else if (key == "sample")
+    {
+      sample = ParseNumber (key, value);
+    }
+  else if (key == "steady-tol")
+    {
+      steadyTol = ParseNumber (key, value);
+    }
+  else if (key == "delay-bin")
+    {
+      delayBin = ParseNumber (key, value);
+      NS_ABORT_MSG_UNLESS (delayBin > 0, "delay-bin must be positive");
+    }
+  else if (key == "rho-min")
+    {
+      rhoMin = ParseNumber (key, value);
+    }
+  else if (key == "rho-max")
+    {
+      rhoMax = ParseNumber (key, value);
+    }
+  else if (key == "direction")
+    {
+      if (value != "uplink" && value != "downlink" && value != "random")
+        {
+          double f = ParseNumber (key, value);
+          NS_ABORT_MSG_UNLESS (f >= 0 && f <= 1, "direction: downlink fraction must be within 0..1, got " << value);
+        }
+      direction = value;
+    }
+  else if (key == "stations")
+    {
+      stations = ParseNumber (key, value);
+    }
+  else if (key == "distance")
+    {
+      distance = ParseNumber (key, value);
+    }
+  else if (key == "seed")
+    {
+      seed = ParseNumber (key, value);
+    }
+  else if (key == "run")
+    {
+      run = ParseNumber (key, value);
+      NS_ABORT_MSG_IF (placement == "antithetic" && run == 0, "antithetic placement pairs runs 2k-1 and 2k; run 0 has no partner");
+    }
+  else
+    {
+      NS_FATAL_ERROR ("unknown trial key \"" << key << "\"");
+    }
+}
+
+inline std::string
+TrialSpec::Get (const std::string &key) const
+{
+  if (key == "manager")
+    {
+      return manager;
+    }
+  else if (key == "fading")
+    {
+      return fading;
+    }
+  else if (key == "fading-model")
+    {
+      return fadingModel;
+    }
+  else if (key == "cull")
+    {
+      return cull;
+    }
+  else if (key == "error-model")
+    {
+      return errorModel;
+    }
+  else if (key == "placement")
+    {
+      return placement;
+    }
+  else if (key == "data-rate")
+    {
+      return dataRate;
+    }
+  else if (key == "packet-size")
+    {
+      return FormatNumber (packetSize);
+    }
+  else if (key == "duration")
+    {
+      return FormatNumber (duration);
+    }
+  else if (key == "measure-from")
+    {
+      return FormatNumber (measureFrom);
+    }
+  else if (key == "measure-to")
+    {
+      return FormatNumber (measureTo);
+    }
+  else if (key == "sample")
+    {
+      return FormatNumber (sample);
+    }
+  else if (key == "steady-tol")
+    {
+      return FormatNumber (steadyTol);
+    }
+  else if (key == "delay-bin")
+    {
+      return FormatNumber (delayBin);
+    }
+  else if (key == "rho-min")
+    {
+      return FormatNumber (rhoMin);
+    }
+  else if (key == "rho-max")
+    {
+      return FormatNumber (rhoMax);
+    }
+  else if (key == "direction")
+    {
+      return direction;
+    }
+  else if (key == "stations")
+    {
+      return FormatNumber (stations);
+    }
+  else if (key == "distance")
+    {
+      return FormatNumber (distance);
+    }
+  else if (key == "seed")
+    {
+      return FormatNumber (seed);
+    }
+  else if (key == "run")
+    {
+      return FormatNumber (run);
+    }
+  NS_FATAL_ERROR ("unknown trial key \"" << key << "\"");
+  return "";
+}
+
+inline std::string
+TrialSpec::ToString (void) const
+{
+  const std::vector<std::string> &keys = GetKeys ();
+  std::string s;
+  for (uint32_t i = 0; i < keys.size (); i++)
+    {
+      s += (i ? " " : "") + keys[i] + "=" + Get (keys[i]);
+    }
+  return s;
+}
+
+inline std::string
+TrialSpec::GetPointKey (void) const
+{
+  const std::vector<std::string> &keys = GetKeys ();
+  std::string s;
+  for (uint32_t i = 0; i < keys.size (); i++)
+    {
+      if (!IsReplicationKey (keys[i]))
+        {
+          s += (s.empty () ? "" : " ") + keys[i] + "=" + Get (keys[i]);
+        }
+    }
+  return s;
+}
+
+// missing keys keep their defaults
+inline TrialSpec
+TrialSpec::Parse (const std::string &line)
+{
+  TrialSpec spec;
+  std::istringstream is (line);
+  std::string field;
+  while (is >> field)
+    {
+      std::string::size_type eq = field.find ('=');
+      NS_ABORT_MSG_IF (eq == std::string::npos, "expected key=value, got \"" << field << "\"");
+      spec.Set (field.substr (0, eq), field.substr (eq + 1));
+    }
+  return spec;
+}
+
+/*
+ * A sweep: a list of values for every trial key, expanded into the
+ * cartesian product of trials.  Keys with more than one value are the
+ * sweep's axes.  Values are given as comma separated lists, and numeric
+ * keys also take start:step:stop ranges, so part1's sweep reads
+ *
+ *   # first.cc
+ *   placement = line
+ *   manager   = aarf, cara
+ *   fading    = none, rayleigh
+ *   distance  = 5:5:100
+ *   seed      = 2:2:10
+ *
+ * The same "key = values" lines can come from a --config file or from
+ * --<key>=values on the command line.  Besides the trial keys there are
+ * three reporting keys: "rows" names the axis printed one row per value
+ * (by default the innermost axis other than manager and fading),
+ * "label.<fading>" sets how a fading model is named in table headings,
+ * and "pair" names a two-valued axis, such as manager, to compare trial
+ * by trial: every seed and run of one value is paired with the same seed
+ * and run of the other, which draw from the same random streams.
+ *
+ * Sweep-wide options take a single value.  A non-zero "ci-target" turns
+ * on sequential stopping: every point runs "min-reps" replications and
+ * keeps adding more until its "confidence" interval half-width is within
+ * ci-target times the mean, or it reaches "max-reps".  Replication k of a
+ * point uses the k-th seed of the seed list and moves on to the next run
+ * number each time the list is used up, so the first replications are
+ * the same trials a fixed sweep runs.
+ *
+ * Antithetic placement only pays off in pairs, runs 2k-1 and 2k of one
+ * seed, so for those points every listed run brings its partner along
+ * (run = 1 runs 1 and 2), and replications 2j and 2j+1 are the two halves
+ * of one pair: seed j of the list, with runs that move on by two each
+ * time the list is used up.  The halves are correlated by design, so
+ * these points are summarized over pair means: their n counts pairs,
+ * and sequential stopping takes min-reps and max-reps in replications
+ * but starts with at least two pairs.
+ *
+ * A non-zero "refine" makes the row values only a starting grid: wherever
+ * the mean throughput of neighbouring rows differs by more than refine
+ * Kib/s, or the curve turns around, the interval is bisected and the new
+ * point simulated, down to rows "min-step" apart.
+ *
+ * A non-zero "saturate" replaces the throughput table by a search for
+ * each point's capacity: the highest per-flow data rate, between
+ * "min-rate" and "max-rate" Kib/s and to within "rate-tol" of it, at
+ * which the mean packet loss stays within saturate (a fraction).
+ *
+ * A non-zero "latency" adds a table of each point's mean loss rate and
+ * its delay and jitter percentiles over all replications.
+ *
+ * "batch" is how many trials sharing seed, run and duration one child may
+ * simulate together, e.g. all twenty distances of a part1 seed.  Results
+ * don't depend on it; it only trades parallelism for less overhead.
+ */
+class SweepSpec
+{
+public:
+  SweepSpec ();
+
+  void Set (const std::string &key, const std::string &values);
+  const std::vector<std::string> &GetValues (const std::string &key) const;
+  double GetOption (const std::string &key) const;
+  void Load (const std::string &filename);
+
+  void AddCommandLine (CommandLine &cmd);
+  void ApplyCommandLine (void);
+
+  std::string GetRowKey (void) const;
+  std::string GetPairKey (void) const;
+  std::vector<std::string> GetGroupKeys (void) const;
+  std::string GetGroupLabel (const TrialSpec &spec) const;
+
+  std::vector<TrialSpec> Expand (void) const;
+  std::vector<TrialSpec> ExpandPoints (void) const;
+  TrialSpec GetReplication (const TrialSpec &point, uint32_t k) const;
+  std::vector<std::string> GetRuns (const TrialSpec &point) const;
+
+private:
+  static std::vector<std::string> ParseValues (const std::string &key, const std::string &values);
+  std::vector<TrialSpec> Expand (bool replications) const;
+
+  std::map<std::string, std::vector<std::string> > m_values;
+  std::map<std::string, std::string> m_options;
+  std::map<std::string, std::string> m_labels;
+  std::string m_rows;
+  std::string m_pair;
+  std::map<std::string, std::string> m_overrides; // --<key> storage for CommandLine
+};
+
+inline
+SweepSpec::SweepSpec ()
+{
+  TrialSpec defaults;
+  const std::vector<std::string> &keys = TrialSpec::GetKeys ();
+  for (uint32_t i = 0; i < keys.size (); i++)
+    {
+      m_values[keys[i]] = std::vector<std::string> (1, defaults.Get (keys[i]));
+    }
+  m_values["seed"] = ParseValues ("seed", "2:2:10"); // seeds (y+1)*2 for y = 0..4
+  m_labels["none"] = "NO_FADING";
+  m_labels["rayleigh"] = "Rayleigh";
+  m_options["ci-target"] = "0";
+  m_options["min-reps"] = "3";
+  m_options["max-reps"] = "50";
+  m_options["confidence"] = "0.95";
+  m_options["refine"] = "0";
+  m_options["min-step"] = "1";
+  m_options["saturate"] = "0";
+  m_options["min-rate"] = "64";
+  m_options["max-rate"] = "20480"; // the drivers' 20Mib/s
+  m_options["rate-tol"] = "0.02";
+  m_options["latency"] = "0";
+  m_options["batch"] = "1";
+}
+
+inline std::vector<std::string>
+SweepSpec::ParseValues (const std::string &key, const std::string &values)
+{
+  std::vector<std::string> out;
+  std::istringstream is (values);
+  std::string item;
+  while (std::getline (is, item, ','))
+    {
+      item = Trim (item);
+      if (item.empty ())
+        {
+          continue;
+        }
+      if (key == "manager" && (item == "adaptive" || item == "constant"))
+        {
+          std::vector<std::string> names = GetRateManagerNames (item == "constant");
+          out.insert (out.end (), names.begin (), names.end ());
+          continue;
+        }
+      std::string::size_type c1 = item.find (':');
+      if (c1 == std::string::npos || key == "manager")
+        {
+          out.push_back (item);
+          continue;
+        }
+      std::string::size_type c2 = item.find (':', c1 + 1);
+      NS_ABORT_MSG_IF (c2 == std::string::npos, "range \"" << item << "\" should be start:step:stop");
+      double start = ParseNumber (key, item.substr (0, c1));
+      double step = ParseNumber (key, item.substr (c1 + 1, c2 - c1 - 1));
+      double stop = ParseNumber (key, item.substr (c2 + 1));
+      NS_ABORT_MSG_IF (step <= 0, "range \"" << item << "\" needs a positive step");
+      uint32_t n = floor ((stop - start) / step + 1e-9) + 1;
+      for (uint32_t k = 0; k < n; k++)
+        {
+          out.push_back (FormatNumber (start + k * step));
+        }
+    }
+  NS_ABORT_MSG_IF (out.empty (), "no values given for \"" << key << "\"");
+  return out;
+}
+
+inline void
+SweepSpec::Set (const std::string &key, const std::string &values)
+{
+  if (key == "rows")
+    {
+      NS_ABORT_MSG_IF (m_values.find (values) == m_values.end (), "rows: unknown key \"" << values << "\"");
+      m_rows = values;
+      return;
+    }
+  if (key == "pair")
+    {
+      NS_ABORT_MSG_IF (m_values.find (values) == m_values.end () || TrialSpec::IsReplicationKey (values),
+                       "pair: \"" << values << "\" is not a trial axis");
+      m_pair = values;
+      return;
+    }
+  if (key.compare (0, 6, "label.") == 0)
+    {
+      m_labels[key.substr (6)] = values;
+      return;
+    }
+  if (m_options.find (key) != m_options.end ())
+    {
+      ParseNumber (key, values);
+      m_options[key] = values;
+      return;
+    }
+  NS_ABORT_MSG_IF (m_values.find (key) == m_values.end (), "unknown sweep key \"" << key << "\"");
+  std::vector<std::string> parsed = ParseValues (key, values);
+  TrialSpec check;
+  for (uint32_t i = 0; i < parsed.size (); i++)
+    {
+      check.Set (key, parsed[i]); // reject bad values now rather than in a worker
+    }
+  m_values[key] = parsed;
+}
+
+inline const std::vector<std::string> &
+SweepSpec::GetValues (const std::string &key) const
+{
+  std::map<std::string, std::vector<std::string> >::const_iterator i = m_values.find (key);
+  NS_ABORT_MSG_IF (i == m_values.end (), "unknown sweep key \"" << key << "\"");
+  return i->second;
+}
+
+inline double
+SweepSpec::GetOption (const std::string &key) const
+{
+  std::map<std::string, std::string>::const_iterator i = m_options.find (key);
+  NS_ABORT_MSG_IF (i == m_options.end (), "unknown sweep option \"" << key << "\"");
+  return ParseNumber (key, i->second);
+}
+
+inline void
+SweepSpec::Load (const std::string &filename)
+{
+  std::ifstream in (filename.c_str ());
+  NS_ABORT_MSG_UNLESS (in, "cannot open sweep config \"" << filename << "\"");
+  std::string line;
+  uint32_t lineNo = 0;
+  while (std::getline (in, line))
+    {
+      lineNo++;
+      line = Trim (line.substr (0, line.find ('#')));
+      if (line.empty ())
+        {
+          continue;
+        }
+      std::string::size_type eq = line.find ('=');
+      NS_ABORT_MSG_IF (eq == std::string::npos, filename << ":" << lineNo << ": expected key = values");
+      Set (Trim (line.substr (0, eq)), Trim (line.substr (eq + 1)));
+    }
+}
+
+inline void
+SweepSpec::AddCommandLine (CommandLine &cmd)
+{
+  const std::vector<std::string> &keys = TrialSpec::GetKeys ();
+  for (uint32_t i = 0; i < keys.size (); i++)
+    {
+      cmd.AddValue (keys[i], "Sweep values for " + keys[i] + " (a,b,c or start:step:stop)", m_overrides[keys[i]]);
+    }
+  cmd.AddValue ("rows", "Axis printed one row per value", m_overrides["rows"]);
+  cmd.AddValue ("pair", "Two-valued axis whose values are compared seed by seed", m_overrides["pair"]);
+  cmd.AddValue ("ci-target", "Add replications until the CI half-width is within this fraction of the mean (0: fixed seed list)", m_overrides["ci-target"]);
+  cmd.AddValue ("min-reps", "Replications every point runs when ci-target is set", m_overrides["min-reps"]);
+  cmd.AddValue ("max-reps", "Most replications a point may run when ci-target is set", m_overrides["max-reps"]);
+  cmd.AddValue ("confidence", "Confidence level of the reported intervals", m_overrides["confidence"]);
+  cmd.AddValue ("refine", "Bisect row intervals whose throughput changes by more than this many Kib/s (0: fixed rows)", m_overrides["refine"]);
+  cmd.AddValue ("min-step", "Smallest row spacing refine may bisect down to", m_overrides["min-step"]);
+  cmd.AddValue ("saturate", "Search each point for the highest data rate whose loss stays within this fraction (0: off)", m_overrides["saturate"]);
+  cmd.AddValue ("min-rate", "Lowest per-flow data rate saturate tries, Kib/s", m_overrides["min-rate"]);
+  cmd.AddValue ("max-rate", "Highest per-flow data rate saturate tries, Kib/s", m_overrides["max-rate"]);
+  cmd.AddValue ("rate-tol", "Relative precision saturate finds the rate to", m_overrides["rate-tol"]);
+  cmd.AddValue ("latency", "Also print each point's loss and delay and jitter percentiles (0: off)", m_overrides["latency"]);
+  cmd.AddValue ("batch", "Most trials sharing seed, run and duration simulated together in one process", m_overrides["batch"]);
+}
+
+inline void
+SweepSpec::ApplyCommandLine (void)
+{
+  for (std::map<std::string, std::string>::const_iterator i = m_overrides.begin (); i != m_overrides.end (); ++i)
+    {
+      if (!i->second.empty ())
+        {
+          Set (i->first, i->second);
+        }
+    }
+}
+
+inline std::string
+SweepSpec::GetRowKey (void) const
+{
+  if (!m_rows.empty ())
+    {
+      return m_rows;
+    }
+  const std::vector<std::string> &keys = TrialSpec::GetKeys ();
+  std::string row = "distance";
+  for (uint32_t i = 0; i < keys.size (); i++)
+    {
+      if (keys[i] != "manager" && keys[i] != "fading" && !TrialSpec::IsReplicationKey (keys[i])
+          && GetValues (keys[i]).size () > 1)
+        {
+          row = keys[i];
+        }
+    }
+  return row;
+}
+
+// empty unless a paired comparison was asked for
+inline std::string
+SweepSpec::GetPairKey (void) const
+{
+  return m_pair;
+}
+
+inline std::vector<std::string>
+SweepSpec::GetGroupKeys (void) const
+{
+  const std::vector<std::string> &keys = TrialSpec::GetKeys ();
+  std::string row = GetRowKey ();
+  std::vector<std::string> groups;
+  for (uint32_t i = 0; i < keys.size (); i++)
+    {
+      if (keys[i] != row && !TrialSpec::IsReplicationKey (keys[i]) && GetValues (keys[i]).size () > 1)
+        {
+          groups.push_back (keys[i]);
+        }
+    }
+  return groups;
+}
+
+// e.g. "AARF_NO_FADING", or "CARA_Rayleigh_data-rate=10Mib/s" when data rate is an axis too
+inline std::string
+SweepSpec::GetGroupLabel (const TrialSpec &spec) const
+{
+  std::string label;
+  for (std::string::size_type i = 0; i < spec.manager.size (); i++)
+    {
+      label += toupper (spec.manager[i]);
+    }
+  std::map<std::string, std::string>::const_iterator l = m_labels.find (spec.fading);
+  label += "_" + (l != m_labels.end () ? l->second : spec.fading);
+  std::vector<std::string> groups = GetGroupKeys ();
+  for (uint32_t i = 0; i < groups.size (); i++)
+    {
+      if (groups[i] != "manager" && groups[i] != "fading")
+        {
+          label += "_" + groups[i] + "=" + spec.Get (groups[i]);
+        }
+    }
+  return label;
+}
+
+/*
+ * Group axes vary slowest, then the row axis, then the replications, so
+ * every table row is a contiguous run of trials and every group a
+ * contiguous run of rows.
+ */
+inline std::vector<TrialSpec>
+SweepSpec::Expand (void) const
+{
+  return Expand (true);
+}
+
+// one trial per point, carrying replication 0's seed and run
+inline std::vector<TrialSpec>
+SweepSpec::ExpandPoints (void) const
+{
+  return Expand (false);
+}
+
+inline TrialSpec
+SweepSpec::GetReplication (const TrialSpec &point, uint32_t k) const
+{
+  const std::vector<std::string> &seeds = GetValues ("seed");
+  TrialSpec spec = point;
+  if (point.placement == "antithetic")
+    {
+      uint32_t j = k / 2;
+      spec.Set ("seed", seeds[j % seeds.size ()]);
+      spec.run = ParseNumber ("run", GetRuns (point)[0]) + 2 * (j / seeds.size ()) + k % 2;
+      return spec;
+    }
+  spec.Set ("seed", seeds[k % seeds.size ()]);
+  spec.run = ParseNumber ("run", GetValues ("run")[0]) + k / seeds.size ();
+  return spec;
+}
+
+// the run list, completed to whole antithetic pairs (2k-1, 2k) when the point needs them
+inline std::vector<std::string>
+SweepSpec::GetRuns (const TrialSpec &point) const
+{
+  const std::vector<std::string> &runs = GetValues ("run");
+  if (point.placement != "antithetic")
+    {
+      return runs;
+    }
+  std::vector<std::string> paired;
+  for (uint32_t i = 0; i < runs.size (); i++)
+    {
+      uint64_t run = ParseNumber ("run", runs[i]);
+      NS_ABORT_MSG_IF (run == 0, "antithetic placement pairs runs 2k-1 and 2k; run 0 has no partner");
+      uint64_t first = run % 2 ? run : run - 1;
+      for (uint64_t r = first; r <= first + 1; r++)
+        {
+          std::string value = FormatNumber (r);
+          if (std::find (paired.begin (), paired.end (), value) == paired.end ())
+            {
+              paired.push_back (value);
+            }
+        }
+    }
+  return paired;
+}
+
+inline std::vector<TrialSpec>
+SweepSpec::Expand (bool replications) const
+{
+  const std::vector<std::string> &keys = TrialSpec::GetKeys ();
+  std::string row = GetRowKey ();
+  std::vector<std::string> order;
+  for (uint32_t i = 0; i < keys.size (); i++)
+    {
+      if (keys[i] != row && !TrialSpec::IsReplicationKey (keys[i]))
+        {
+          order.push_back (keys[i]);
+        }
+    }
+  order.push_back (row);
+  order.push_back ("seed");
+  order.push_back ("run");
+
+  std::vector<TrialSpec> trials (1);
+  for (uint32_t k = 0; k < order.size (); k++)
+    {
+      std::vector<std::string> values = GetValues (order[k]);
+      if (!replications && TrialSpec::IsReplicationKey (order[k]))
+        {
+          values.resize (1);
+        }
+      std::vector<TrialSpec> next;
+      next.reserve (trials.size () * values.size ());
+      for (uint32_t t = 0; t < trials.size (); t++)
+        {
+          if (replications && order[k] == "run")
+            {
+              values = GetRuns (trials[t]);
+            }
+          for (uint32_t v = 0; v < values.size (); v++)
+            {
+              TrialSpec spec = trials[t];
+              spec.Set (order[k], values[v]);
+              next.push_back (spec);
+            }
+        }
+      trials.swap (next);
+    }
+  return trials;
+}
+
+} // namespace ns3
+
+#endif /* SCENARIO_H */
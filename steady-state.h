@@ -0,0 +1,200 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef STEADY_STATE_H
+#define STEADY_STATE_H
+
+#include "ns3/core-module.h"
+#include "ns3/flow-monitor-module.h"
+
+#include "replication.h"
+
+#include <map>
+#include <vector>
+
+namespace ns3 {
+
+/*
+ * Watches a trial's aggregate throughput in fixed windows and stops the
+ * simulation once it has settled.
+ *
+ * From the end of the warm-up, FlowMonitor's per-flow rxBytes are
+ * snapshotted every interval seconds, giving one aggregate throughput
+ * sample per window.  After each window an MSER rule picks how many of the
+ * leading windows still look like transient (the d minimising the
+ * variance of the remaining mean, d at most half the windows), and the
+ * remaining windows are grouped into ten batch means.  Once there are at
+ * least two windows per batch and the batch means' CI half-width is within
+ * tolerance times their mean, Simulator::Stop is called.
+ *
+ * The steady-state throughput of a flow is its rxBytes growth from the
+ * truncation point to the last snapshot, so the transient never enters
+ * the estimate whether or not the run converged.
+ */
+class SteadyStateMonitor
+{
+public:
+  SteadyStateMonitor (Ptr<FlowMonitor> flowmon, double warmup, double interval,
+                      double tolerance, double confidence);
+
+  void Start (void);
+
+  bool IsConverged (void) const;
+  double GetStart (void) const; // simulated time the steady-state estimate starts at
+  double GetFlowThroughput (FlowId flow) const; // Kib/s from GetStart () to the last snapshot
+
+private:
+  static const uint32_t BATCHES = 10;
+
+  void Sample (void);
+  uint32_t GetTruncation (void) const;
+
+  Ptr<FlowMonitor> m_flowmon;
+  double m_warmup;
+  double m_interval;
+  double m_tolerance;
+  double m_confidence;
+  bool m_converged;
+  std::vector<std::map<FlowId, uint64_t> > m_snapshots; // rxBytes per flow at warmup + k * interval
+  std::vector<double> m_samples;                        // aggregate Kib/s over window k
+};
+
+inline
+SteadyStateMonitor::SteadyStateMonitor (Ptr<FlowMonitor> flowmon, double warmup, double interval,
+                                        double tolerance, double confidence)
+  : m_flowmon (flowmon),
+    m_warmup (warmup),
+    m_interval (interval),
+    m_tolerance (tolerance),
+    m_confidence (confidence),
+    m_converged (false)
+{
+}
+
+inline void
+SteadyStateMonitor::Start (void)
+{
+  Simulator::Schedule (Seconds (m_warmup), &SteadyStateMonitor::Sample, this);
+}
+
+inline void
+SteadyStateMonitor::Sample (void)
+{
+  std::map<FlowId, FlowMonitor::FlowStats> stats = m_flowmon->GetFlowStats ();
+  std::map<FlowId, uint64_t> snapshot;
+  uint64_t total = 0;
+  for (std::map<FlowId, FlowMonitor::FlowStats>::const_iterator i = stats.begin (); i != stats.end (); ++i)
+    {
+      snapshot[i->first] = i->second.rxBytes;
+      total += i->second.rxBytes;
+    }
+  if (!m_snapshots.empty ())
+    {
+      uint64_t previous = 0;
+      const std::map<FlowId, uint64_t> &last = m_snapshots.back ();
+      for (std::map<FlowId, uint64_t>::const_iterator i = last.begin (); i != last.end (); ++i)
+        {
+          previous += i->second;
+        }
+      m_samples.push_back ((total - previous) * 8.0 / (m_interval * 1024));
+    }
+  m_snapshots.push_back (snapshot);
+
+  uint32_t d = GetTruncation ();
+  uint32_t perBatch = (m_samples.size () - d) / BATCHES;
+  if (perBatch >= 2)
+    {
+      ReplicationStats batches;
+      uint32_t first = m_samples.size () - perBatch * BATCHES;
+      for (uint32_t b = 0; b < BATCHES; b++)
+        {
+          double sum = 0;
+          for (uint32_t k = 0; k < perBatch; k++)
+            {
+              sum += m_samples[first + b * perBatch + k];
+            }
+          batches.Add (sum / perBatch);
+        }
+      if (batches.GetHalfWidth (m_confidence) <= m_tolerance * fabs (batches.GetMean ()))
+        {
+          m_converged = true;
+          Simulator::Stop ();
+          return;
+        }
+    }
+  Simulator::Schedule (Seconds (m_interval), &SteadyStateMonitor::Sample, this);
+}
+
+inline uint32_t
+SteadyStateMonitor::GetTruncation (void) const
+{
+  uint32_t n = m_samples.size ();
+  double sum = 0;
+  double sumSq = 0;
+  uint32_t best = 0;
+  double bestScore = INFINITY;
+  // walk d down from n/2 so the suffix sums can be built up incrementally
+  for (uint32_t d = n; d-- > 0; )
+    {
+      sum += m_samples[d];
+      sumSq += m_samples[d] * m_samples[d];
+      if (d > n / 2)
+        {
+          continue;
+        }
+      double m = n - d;
+      double score = (sumSq - sum * sum / m) / (m * m);
+      if (score <= bestScore)
+        {
+          bestScore = score;
+          best = d;
+        }
+    }
+  return best;
+}
+
+inline bool
+SteadyStateMonitor::IsConverged (void) const
+{
+  return m_converged;
+}
+
+inline double
+SteadyStateMonitor::GetStart (void) const
+{
+  return m_warmup + GetTruncation () * m_interval;
+}
+
+inline double
+SteadyStateMonitor::GetFlowThroughput (FlowId flow) const
+{
+  uint32_t d = GetTruncation ();
+  if (m_snapshots.size () < d + 2)
+    {
+      return 0.0;
+    }
+  const std::map<FlowId, uint64_t> &from = m_snapshots[d];
+  const std::map<FlowId, uint64_t> &to = m_snapshots.back ();
+  std::map<FlowId, uint64_t>::const_iterator a = from.find (flow);
+  std::map<FlowId, uint64_t>::const_iterator b = to.find (flow);
+  uint64_t bytes = (b != to.end () ? b->second : 0) - (a != from.end () ? a->second : 0);
+  return bytes * 8.0 / ((m_snapshots.size () - 1 - d) * m_interval * 1024);
+}
+
+} // namespace ns3
+
+#endif /* STEADY_STATE_H */
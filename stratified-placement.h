@@ -0,0 +1,179 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef STRATIFIED_PLACEMENT_H
+#define STRATIFIED_PLACEMENT_H
+
+#include "ns3/core-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/rng-stream.h"
+
+#include <vector>
+#include <algorithm>
+#include <math.h>
+
+namespace ns3 {
+
+/*
+ * Places n stations on a disc around the origin with the distribution
+ * RandomDiscPositionAllocator gives them with a uniform Rho: radius
+ * uniform on [rhoMin, rhoMax], angle uniform.  Instead of n independent
+ * draws, the radius range is cut into n equally likely rings and the
+ * circle into n sectors, and each station gets a ring and a sector of its
+ * own (a Latin hypercube), at a uniform point inside them.  Rings and
+ * sectors are dealt out by random permutation, so every station on its
+ * own still has exactly the plain distribution and means stay unbiased,
+ * but no draw can pile all the stations near the AP or at the rim.
+ *
+ * With SetAntithetic, runs 2k-1 and 2k make a pair: both draw the same
+ * uniforms, from run 2k-1's substream of the stream this allocator was
+ * given, and run 2k uses 1 - u for each of them, putting every station
+ * of one layout near where the other has a far one.  A lone run gets no
+ * benefit, so sweeps run antithetic points in whole pairs of runs (see
+ * SweepSpec::GetRuns).  Otherwise the draws are those of that stream in
+ * the current run, as for any other variable.
+ */
+class StratifiedDiscPositionAllocator : public PositionAllocator
+{
+public:
+  static TypeId GetTypeId (void);
+
+  StratifiedDiscPositionAllocator ();
+
+  void SetDisc (double rhoMin, double rhoMax, uint32_t n);
+  void SetAntithetic (bool antithetic);
+
+  virtual Vector GetNext (void) const;
+  virtual int64_t AssignStreams (int64_t stream);
+
+private:
+  void Place (void) const;
+
+  double m_rhoMin;
+  double m_rhoMax;
+  uint32_t m_n;
+  bool m_antithetic;
+  int64_t m_stream;
+  mutable std::vector<Vector> m_positions; // all n, drawn on the first GetNext
+  mutable uint32_t m_next;
+};
+
+inline TypeId
+StratifiedDiscPositionAllocator::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::StratifiedDiscPositionAllocator")
+    .SetParent<PositionAllocator> ()
+    .AddConstructor<StratifiedDiscPositionAllocator> ();
+  return tid;
+}
+
+inline
+StratifiedDiscPositionAllocator::StratifiedDiscPositionAllocator ()
+  : m_rhoMin (0.0),
+    m_rhoMax (0.0),
+    m_n (1),
+    m_antithetic (false),
+    m_stream (-1),
+    m_next (0)
+{
+}
+
+inline void
+StratifiedDiscPositionAllocator::SetDisc (double rhoMin, double rhoMax, uint32_t n)
+{
+  NS_ABORT_MSG_IF (n == 0, "nothing to place");
+  m_rhoMin = rhoMin;
+  m_rhoMax = rhoMax;
+  m_n = n;
+  m_positions.clear ();
+  m_next = 0;
+}
+
+inline void
+StratifiedDiscPositionAllocator::SetAntithetic (bool antithetic)
+{
+  m_antithetic = antithetic;
+  m_positions.clear ();
+  m_next = 0;
+}
+
+inline int64_t
+StratifiedDiscPositionAllocator::AssignStreams (int64_t stream)
+{
+  m_stream = stream;
+  m_positions.clear ();
+  m_next = 0;
+  return 1;
+}
+
+inline void
+StratifiedDiscPositionAllocator::Place (void) const
+{
+  NS_ABORT_MSG_IF (m_stream < 0, "StratifiedDiscPositionAllocator needs AssignStreams before its first position");
+  uint64_t run = SeedManager::GetRun ();
+  NS_ABORT_MSG_IF (m_antithetic && run == 0, "antithetic placement pairs runs 2k-1 and 2k; run 0 has no partner");
+  bool reflect = m_antithetic && run % 2 == 0;
+  if (reflect)
+    {
+      run--; // draw what the pair's odd run draws
+    }
+  RngStream rng (SeedManager::GetSeed (), (1ULL << 63) + m_stream, run); // as RandomVariableStream::SetStream (m_stream) would
+
+  std::vector<uint32_t> ring (m_n);
+  std::vector<uint32_t> sector (m_n);
+  for (uint32_t i = 0; i < m_n; i++)
+    {
+      ring[i] = i;
+      sector[i] = i;
+    }
+  for (uint32_t i = m_n; i-- > 1; ) // Fisher-Yates
+    {
+      std::swap (ring[i], ring[std::min (i, (uint32_t)(rng.RandU01 () * (i + 1)))]);
+      std::swap (sector[i], sector[std::min (i, (uint32_t)(rng.RandU01 () * (i + 1)))]);
+    }
+
+  m_positions.clear ();
+  for (uint32_t i = 0; i < m_n; i++)
+    {
+      double u = (ring[i] + rng.RandU01 ()) / m_n;
+      double v = (sector[i] + rng.RandU01 ()) / m_n;
+      if (reflect)
+        {
+          u = 1 - u;
+          v = 1 - v;
+        }
+      double rho = m_rhoMin + (m_rhoMax - m_rhoMin) * u;
+      double theta = 2 * M_PI * v;
+      m_positions.push_back (Vector (rho * cos (theta), rho * sin (theta), 0.0));
+    }
+  m_next = 0;
+}
+
+inline Vector
+StratifiedDiscPositionAllocator::GetNext (void) const
+{
+  if (m_positions.empty ())
+    {
+      Place ();
+    }
+  NS_ABORT_MSG_IF (m_next == m_positions.size (), "more stations placed than the " << m_n << " the disc was stratified for");
+  return m_positions[m_next++];
+}
+
+} // namespace ns3
+
+#endif /* STRATIFIED_PLACEMENT_H */
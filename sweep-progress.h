@@ -0,0 +1,200 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef SWEEP_PROGRESS_H
+#define SWEEP_PROGRESS_H
+
+#include "ns3/core-module.h"
+
+#include "scenario.h"
+#include "trial-result.h"
+#include "trial.h"
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+namespace ns3 {
+
+/*
+ * Live progress of a sweep, kept by the parent from the trials' results
+ * as they come back, so the simulations themselves pay nothing for it.
+ * A report says how many of the trials known so far are done, the point
+ * that finished last, the mean wall time of the last WINDOW trials, and
+ * an ETA.
+ *
+ * The ETA is cost-aware: a trial is expected to cost in proportion to
+ * its stations times its duration, and the remaining cost is converted
+ * to time at the rate elapsed real time has bought cost units so far,
+ * which accounts for the number of jobs as well.  Cached trials count as
+ * done and cost nothing.  Adaptive and refined sweeps add trials as they
+ * go, so their ETA covers only the rounds already started.
+ *
+ * Reports go to out, if set, at most once a second on a terminal (over
+ * the previous one) and every ten seconds otherwise, and to a status
+ * file, if set, which is replaced whole each time.
+ */
+class SweepProgress
+{
+public:
+  static const uint32_t WINDOW = 20;
+
+  SweepProgress (const SweepSpec &sweep, FILE *out, const std::string &statusFile);
+
+  void Start (const std::vector<TrialSpec> &pending, uint32_t cached);
+  void Finished (const TrialSpec &spec, const TrialResult &result);
+  void Stop (void);
+
+  static double GetCost (const TrialSpec &spec);
+  static std::string FormatDuration (double seconds);
+
+private:
+  void Report (bool force);
+
+  const SweepSpec &m_sweep;
+  FILE *m_out;
+  bool m_terminal;
+  std::string m_statusFile;
+  uint32_t m_total;
+  uint32_t m_done;
+  double m_totalCost;
+  double m_doneCost;
+  double m_start;
+  double m_lastReport;
+  std::string m_current;
+  std::deque<double> m_recent; // wall seconds of the last WINDOW trials
+};
+
+inline
+SweepProgress::SweepProgress (const SweepSpec &sweep, FILE *out, const std::string &statusFile)
+  : m_sweep (sweep),
+    m_out (out),
+    m_terminal (out && isatty (fileno (out))),
+    m_statusFile (statusFile),
+    m_total (0),
+    m_done (0),
+    m_totalCost (0.0),
+    m_doneCost (0.0),
+    m_start (0.0),
+    m_lastReport (0.0)
+{
+}
+
+// expected cost of a trial, in station-seconds of simulated traffic
+inline double
+SweepProgress::GetCost (const TrialSpec &spec)
+{
+  return spec.stations * spec.duration;
+}
+
+inline std::string
+SweepProgress::FormatDuration (double seconds)
+{
+  char buf[32];
+  unsigned long s = seconds > 0 ? (unsigned long)(seconds + 0.5) : 0;
+  snprintf (buf, sizeof (buf), "%lu:%02lu:%02lu", s / 3600, s / 60 % 60, s % 60);
+  return buf;
+}
+
+inline void
+SweepProgress::Start (const std::vector<TrialSpec> &pending, uint32_t cached)
+{
+  if (m_start == 0)
+    {
+      m_start = GetWallClock ();
+    }
+  m_total += pending.size () + cached;
+  m_done += cached;
+  for (uint32_t i = 0; i < pending.size (); i++)
+    {
+      m_totalCost += GetCost (pending[i]);
+    }
+  Report (true);
+}
+
+inline void
+SweepProgress::Finished (const TrialSpec &spec, const TrialResult &result)
+{
+  m_done++;
+  m_doneCost += GetCost (spec);
+  m_current = m_sweep.GetGroupLabel (spec) + " " + m_sweep.GetRowKey () + "=" + spec.Get (m_sweep.GetRowKey ());
+  m_recent.push_back (result.wallSeconds);
+  if (m_recent.size () > WINDOW)
+    {
+      m_recent.pop_front ();
+    }
+  Report (false);
+}
+
+inline void
+SweepProgress::Stop (void)
+{
+  Report (true);
+  if (m_out && m_terminal)
+    {
+      fprintf (m_out, "\n");
+    }
+}
+
+inline void
+SweepProgress::Report (bool force)
+{
+  double now = GetWallClock ();
+  if (!force && now - m_lastReport < (m_terminal || !m_out ? 1.0 : 10.0))
+    {
+      return;
+    }
+  m_lastReport = now;
+
+  double elapsed = now - m_start;
+  double recent = 0;
+  for (uint32_t i = 0; i < m_recent.size (); i++)
+    {
+      recent += m_recent[i] / m_recent.size ();
+    }
+  std::string eta = m_doneCost > 0 ? FormatDuration ((m_totalCost - m_doneCost) * elapsed / m_doneCost) : "?";
+  char line[512];
+  snprintf (line, sizeof (line), "%u/%u trials (%.0f%%), elapsed %s, ETA %s, %.2fs per trial lately%s%s",
+            m_done, m_total, m_total ? 100.0 * m_done / m_total : 100.0, FormatDuration (elapsed).c_str (),
+            eta.c_str (), recent, m_current.empty () ? "" : ", last ", m_current.c_str ());
+
+  if (m_out)
+    {
+      fprintf (m_out, m_terminal ? "\r%s\033[K" : "%s\n", line);
+      fflush (m_out);
+    }
+  if (!m_statusFile.empty ())
+    {
+      std::string tmp = m_statusFile + ".tmp";
+      FILE *f = fopen (tmp.c_str (), "w");
+      if (!f)
+        {
+          NS_FATAL_ERROR ("cannot open \"" << tmp << "\": " << strerror (errno));
+        }
+      fprintf (f, "%s\n", line);
+      fclose (f);
+      rename (tmp.c_str (), m_statusFile.c_str ()); // readers never see a half-written status
+    }
+}
+
+} // namespace ns3
+
+#endif /* SWEEP_PROGRESS_H */
@@ -0,0 +1,245 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SWEEP_RUNNER_H
+#define SWEEP_RUNNER_H
+
+#include "ns3/core-module.h"
+
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+namespace ns3 {
+
+/*
+ * Runs the trials of a sweep in forked child processes, at most "jobs" of
+ * them at a time.  The Simulator is a per-process singleton, so every trial
+ * starts from a fresh copy of the parent, which never simulates anything
+ * itself.  A trial returns its result as a string; the child writes it back
+ * over a pipe and the parent stores it at the trial's index, so results come
+ * back in sweep order no matter which child finishes first.
+ *
+ * If a done callback is given, the parent calls it with each trial's index
+ * and result as soon as that trial finishes, in completion order.
+ *
+ * With jobs == 0 the trials run one after another in this process, which is
+ * only meant for stepping through a trial in a debugger.
+ */
+class SweepRunner
+{
+public:
+  typedef Callback<std::string, uint32_t> Trial;
+  typedef Callback<void, uint32_t, std::string> Done;
+
+  SweepRunner (uint32_t jobs);
+
+  static uint32_t GetDefaultJobs (void);
+  static std::string FormatDouble (double value);
+  static double ParseDouble (const std::string &text);
+
+  std::vector<std::string> Run (uint32_t nTrials, Trial trial, Done done = Done ());
+
+private:
+  struct Child
+  {
+    pid_t pid;
+    int fd;
+    uint32_t index;
+  };
+
+  void Spawn (uint32_t index, Trial trial);
+  void Reap (uint32_t slot, std::vector<std::string> &results, Done done);
+
+  uint32_t m_jobs;
+  std::vector<Child> m_children;
+  std::vector<std::string> m_buffers;
+};
+
+inline
+SweepRunner::SweepRunner (uint32_t jobs)
+  : m_jobs (jobs)
+{
+}
+
+inline uint32_t
+SweepRunner::GetDefaultJobs (void)
+{
+  long n = sysconf (_SC_NPROCESSORS_ONLN);
+  return n > 0 ? n : 1;
+}
+
+inline std::string
+SweepRunner::FormatDouble (double value)
+{
+  char buf[32];
+  snprintf (buf, sizeof (buf), "%.17g", value); // enough digits to read back the exact same double
+  return buf;
+}
+
+inline double
+SweepRunner::ParseDouble (const std::string &text)
+{
+  return strtod (text.c_str (), 0);
+}
+
+inline std::vector<std::string>
+SweepRunner::Run (uint32_t nTrials, Trial trial, Done done)
+{
+  std::vector<std::string> results (nTrials);
+  if (m_jobs == 0)
+    {
+      for (uint32_t i = 0; i < nTrials; i++)
+        {
+          results[i] = trial (i);
+          if (!done.IsNull ())
+            {
+              done (i, results[i]);
+            }
+        }
+      return results;
+    }
+
+  uint32_t next = 0;
+  while (next < nTrials || !m_children.empty ())
+    {
+      while (next < nTrials && m_children.size () < m_jobs)
+        {
+          Spawn (next++, trial);
+        }
+
+      std::vector<struct pollfd> fds (m_children.size ());
+      for (uint32_t i = 0; i < m_children.size (); i++)
+        {
+          fds[i].fd = m_children[i].fd;
+          fds[i].events = POLLIN;
+          fds[i].revents = 0;
+        }
+      if (poll (&fds[0], fds.size (), -1) < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+          NS_FATAL_ERROR ("poll failed: " << strerror (errno));
+        }
+
+      // walk backwards so Reap can erase finished children in place
+      for (uint32_t i = fds.size (); i-- > 0; )
+        {
+          if (fds[i].revents == 0)
+            {
+              continue;
+            }
+          char buf[4096];
+          ssize_t n = read (m_children[i].fd, buf, sizeof (buf));
+          if (n > 0)
+            {
+              m_buffers[i].append (buf, n);
+            }
+          else if (n == 0 || errno != EINTR)
+            {
+              Reap (i, results, done);
+            }
+        }
+    }
+  return results;
+}
+
+inline void
+SweepRunner::Spawn (uint32_t index, Trial trial)
+{
+  int pipefd[2];
+  if (pipe (pipefd) < 0)
+    {
+      NS_FATAL_ERROR ("pipe failed: " << strerror (errno));
+    }
+  fflush (0); // otherwise the child inherits, and re-prints, anything still buffered in any stream
+  pid_t pid = fork ();
+  if (pid < 0)
+    {
+      NS_FATAL_ERROR ("fork failed: " << strerror (errno));
+    }
+  if (pid == 0)
+    {
+      close (pipefd[0]);
+      for (uint32_t i = 0; i < m_children.size (); i++)
+        {
+          close (m_children[i].fd);
+        }
+      std::string result = trial (index);
+      const char *p = result.data ();
+      size_t left = result.size ();
+      while (left > 0)
+        {
+          ssize_t n = write (pipefd[1], p, left);
+          if (n < 0 && errno == EINTR)
+            {
+              continue;
+            }
+          if (n < 0)
+            {
+              _exit (1);
+            }
+          p += n;
+          left -= n;
+        }
+      close (pipefd[1]);
+      fflush (stdout);
+      _exit (0);
+    }
+
+  close (pipefd[1]);
+  Child child;
+  child.pid = pid;
+  child.fd = pipefd[0];
+  child.index = index;
+  m_children.push_back (child);
+  m_buffers.push_back (std::string ());
+}
+
+inline void
+SweepRunner::Reap (uint32_t slot, std::vector<std::string> &results, Done done)
+{
+  Child child = m_children[slot];
+  close (child.fd);
+  int status = 0;
+  while (waitpid (child.pid, &status, 0) < 0 && errno == EINTR)
+    {
+    }
+  if (!WIFEXITED (status) || WEXITSTATUS (status) != 0)
+    {
+      NS_FATAL_ERROR ("trial " << child.index << " failed (pid " << child.pid << ", status " << status << ")");
+    }
+  results[child.index] = m_buffers[slot];
+  m_children.erase (m_children.begin () + slot);
+  m_buffers.erase (m_buffers.begin () + slot);
+  if (!done.IsNull ())
+    {
+      done (child.index, results[child.index]);
+    }
+}
+
+} // namespace ns3
+
+#endif /* SWEEP_RUNNER_H */
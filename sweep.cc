@@ -0,0 +1,41 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+/*
+ * Runs any sweep the scenario engine can describe, e.g.
+ *
+ *   ./waf --run "sweep --config=my-sweep.conf --jobs=32"
+ *   ./waf --run "sweep --placement=disc --rho-max=25 --stations=1:5:50 --manager=aarf,cara"
+ *   ./waf --run "sweep --distance=5:5:100 --manager=constant"
+ *
+ * See scenario.h for the keys and value syntax.
+ */
+
+#include "ns3/core-module.h"
+
+#include "sweep.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("Sweep");
+
+int
+main (int argc, char *argv[])
+{
+  SweepSpec sweep;
+  return SweepMain (sweep, argc, argv);
+}
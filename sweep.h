@@ -0,0 +1,1105 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include "ns3/core-module.h"
+
+#include "scenario.h"
+#include "trial.h"
+#include "replication.h"
+#include "result-cache.h"
+#include "trial-output.h"
+#include "trial-cost.h"
+#include "sweep-runner.h"
+#include "trial-server.h"
+#include "sweep-progress.h"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <sstream>
+#include <algorithm>
+#include <stdio.h>
+#include <math.h>
+
+namespace ns3 {
+
+// one point's delays, jitters and loss rates, over all its replications
+struct PointLatency
+{
+  DelayHistogram delays;
+  DelayHistogram jitters;
+  ReplicationStats loss;
+};
+
+/*
+ * Runs batches of trials on the process pool, skipping any trial the
+ * result cache (if one is set) already holds.  Children store their own
+ * results in the cache as they finish, so a sweep that dies part way
+ * keeps everything it completed.  If a writer is set, every trial, cached
+ * or not, is written out as soon as its result is known.  What the
+ * simulated trials cost accumulates in GetCost across calls to Run.
+ *
+ * With SetBatch (n), up to n trials that share seed, run and duration are
+ * simulated together by one child (see RunTrials), which pays the setup
+ * and teardown of a simulation once for all of them.
+ *
+ * Every point's delay and jitter histograms and loss rates are merged over
+ * all its replications, cached or not, for GetLatency.  If a progress
+ * reporter is set, it hears of every trial as it finishes.
+ */
+class TrialRunner
+{
+public:
+  TrialRunner (uint32_t jobs);
+
+  void SetCache (ResultCache *cache);
+  void SetWriter (TrialWriter *writer);
+  void SetBatch (uint32_t batch);
+  void SetProgress (SweepProgress *progress);
+  std::vector<TrialResult> Run (const std::vector<TrialSpec> &trials);
+  const CostSummary &GetCost (void) const;
+  PointLatency GetLatency (const TrialSpec &point) const;
+
+private:
+  std::string RunOne (uint32_t b); // runs in a forked child, see sweep-runner.h
+  void Finished (uint32_t b, std::string result);
+  void MakeBatches (void);
+
+  uint32_t m_jobs;
+  uint32_t m_batch;
+  ResultCache *m_cache;
+  TrialWriter *m_writer;
+  SweepProgress *m_progress;
+  std::vector<TrialSpec> m_pending;
+  std::vector<std::vector<uint32_t> > m_batches; // indices into m_pending
+  CostSummary m_cost;
+  std::map<std::string, PointLatency> m_latency; // by point key
+};
+
+inline
+TrialRunner::TrialRunner (uint32_t jobs)
+  : m_jobs (jobs),
+    m_batch (1),
+    m_cache (0),
+    m_writer (0),
+    m_progress (0)
+{
+}
+
+inline void
+TrialRunner::SetCache (ResultCache *cache)
+{
+  m_cache = cache;
+}
+
+inline void
+TrialRunner::SetWriter (TrialWriter *writer)
+{
+  m_writer = writer;
+}
+
+inline void
+TrialRunner::SetProgress (SweepProgress *progress)
+{
+  m_progress = progress;
+}
+
+inline void
+TrialRunner::SetBatch (uint32_t batch)
+{
+  m_batch = batch > 0 ? batch : 1;
+}
+
+inline const CostSummary &
+TrialRunner::GetCost (void) const
+{
+  return m_cost;
+}
+
+inline PointLatency
+TrialRunner::GetLatency (const TrialSpec &point) const
+{
+  std::map<std::string, PointLatency>::const_iterator i = m_latency.find (point.GetPointKey ());
+  return i != m_latency.end () ? i->second : PointLatency ();
+}
+
+inline void
+TrialRunner::MakeBatches (void)
+{
+  m_batches.clear ();
+  std::map<std::string, uint32_t> open; // seed, run and duration -> batch still taking trials
+  for (uint32_t i = 0; i < m_pending.size (); i++)
+    {
+      const TrialSpec &spec = m_pending[i];
+      std::string key = spec.Get ("seed") + " " + spec.Get ("run") + " " + spec.Get ("duration");
+      bool alone = m_batch == 1 || spec.sample > 0;
+      std::map<std::string, uint32_t>::iterator j = open.find (key);
+      if (!alone && j != open.end () && m_batches[j->second].size () < m_batch)
+        {
+          m_batches[j->second].push_back (i);
+          continue;
+        }
+      m_batches.push_back (std::vector<uint32_t> (1, i));
+      if (!alone)
+        {
+          open[key] = m_batches.size () - 1;
+        }
+    }
+}
+
+inline void
+TrialRunner::Finished (uint32_t b, std::string result)
+{
+  if (!m_writer && !m_progress)
+    {
+      return;
+    }
+  std::istringstream lines (result);
+  std::string line;
+  for (uint32_t k = 0; k < m_batches[b].size () && std::getline (lines, line); k++)
+    {
+      const TrialSpec &spec = m_pending[m_batches[b][k]];
+      TrialResult parsed = TrialResult::Parse (line);
+      if (m_writer)
+        {
+          m_writer->Write (spec, parsed, false);
+        }
+      if (m_progress)
+        {
+          m_progress->Finished (spec, parsed);
+        }
+    }
+}
+
+inline std::string
+TrialRunner::RunOne (uint32_t b)
+{
+  std::vector<TrialSpec> specs;
+  for (uint32_t k = 0; k < m_batches[b].size (); k++)
+    {
+      specs.push_back (m_pending[m_batches[b][k]]);
+    }
+  std::vector<TrialResult> results = RunTrials (specs);
+  std::string out;
+  for (uint32_t k = 0; k < results.size (); k++)
+    {
+      std::string result = results[k].ToString ();
+      if (m_cache)
+        {
+          m_cache->Store (specs[k], result);
+        }
+      out += result + "\n"; // results are single lines, see result-cache.h
+    }
+  return out;
+}
+
+inline std::vector<TrialResult>
+TrialRunner::Run (const std::vector<TrialSpec> &trials)
+{
+  std::vector<std::string> out (trials.size ());
+  std::vector<uint32_t> index;
+  m_pending.clear ();
+  for (uint32_t i = 0; i < trials.size (); i++)
+    {
+      if (!m_cache || !m_cache->Lookup (trials[i], out[i]))
+        {
+          m_pending.push_back (trials[i]);
+          index.push_back (i);
+          continue;
+        }
+      m_cost.AddCached ();
+      if (m_writer)
+        {
+          m_writer->Write (trials[i], TrialResult::Parse (out[i]), true);
+        }
+    }
+
+  if (m_progress)
+    {
+      m_progress->Start (m_pending, trials.size () - m_pending.size ());
+    }
+  MakeBatches ();
+  std::vector<std::string> ran = SweepRunner (m_jobs).Run (m_batches.size (),
+                                                           MakeCallback (&TrialRunner::RunOne, this),
+                                                           MakeCallback (&TrialRunner::Finished, this));
+  for (uint32_t b = 0; b < ran.size (); b++)
+    {
+      std::istringstream lines (ran[b]);
+      for (uint32_t k = 0; k < m_batches[b].size (); k++)
+        {
+          uint32_t p = m_batches[b][k];
+          std::getline (lines, out[index[p]]);
+          m_cost.Add (m_pending[p], TrialResult::Parse (out[index[p]]));
+          if (m_cache)
+            {
+              m_cache->Remember (m_pending[p], out[index[p]]); // the child's Store went to disk, not to our copy
+            }
+        }
+    }
+
+  std::vector<TrialResult> results;
+  results.reserve (out.size ());
+  for (uint32_t i = 0; i < out.size (); i++)
+    {
+      results.push_back (TrialResult::Parse (out[i]));
+      PointLatency &latency = m_latency[trials[i].GetPointKey ()];
+      latency.delays.Merge (results[i].delays);
+      latency.jitters.Merge (results[i].jitters);
+      latency.loss.Add (results[i].GetLossRate ());
+    }
+  return results;
+}
+
+inline std::string
+GetRowName (const std::string &key)
+{
+  if (key == "distance")
+    {
+      return "Distance";
+    }
+  if (key == "stations")
+    {
+      return "St_Nodes";
+    }
+  return key;
+}
+
+/*
+ * Replications per sample of a point.  The two halves of an antithetic
+ * pair are correlated by design, so only whole pairs are independent:
+ * such a point's samples are pair means, and its n, standard deviation
+ * and interval are over pairs.
+ */
+inline uint32_t
+GetPairing (const TrialSpec &point)
+{
+  return point.placement == "antithetic" ? 2 : 1;
+}
+
+// adds a point's replications, in GetReplication order, to its summary, GetPairing at a time
+inline void
+AddSamples (ReplicationStats &stats, const TrialSpec &point, const std::vector<double> &values)
+{
+  uint32_t per = GetPairing (point);
+  NS_ABORT_MSG_IF (values.size () % per, "antithetic replications come in whole pairs");
+  for (uint32_t i = 0; i < values.size (); i += per)
+    {
+      double sum = 0.0;
+      for (uint32_t j = 0; j < per; j++)
+        {
+          sum += values[i + j];
+        }
+      stats.Add (sum / per);
+    }
+}
+
+// folds a fixed sweep's trials, in Expand order, into one summary per point
+inline std::vector<ReplicationStats>
+SummarizePoints (const std::vector<TrialSpec> &trials, const std::vector<TrialResult> &results)
+{
+  std::vector<ReplicationStats> stats;
+  std::vector<double> values;
+  for (uint32_t i = 0; i < trials.size (); i++)
+    {
+      values.push_back (results[i].throughput);
+      if (i + 1 == trials.size () || trials[i + 1].GetPointKey () != trials[i].GetPointKey ())
+        {
+          stats.push_back (ReplicationStats ());
+          AddSamples (stats.back (), trials[i], values);
+          values.clear ();
+        }
+    }
+  return stats;
+}
+
+/*
+ * Sequential stopping: every point starts with min-reps replications, and
+ * each round adds as many more as the variance seen so far says the point
+ * needs, up to max-reps.  Antithetic points count in pairs (see
+ * GetPairing): they start with at least two and stop on the interval
+ * over pair means.  A round's trials all go to the pool together,
+ * and which trials run depends only on earlier rounds' results, so the
+ * outcome does not depend on the number of jobs.
+ */
+inline std::vector<ReplicationStats>
+RunAdaptive (const SweepSpec &sweep, const std::vector<TrialSpec> &points, TrialRunner &runner)
+{
+  double target = sweep.GetOption ("ci-target");
+  double confidence = sweep.GetOption ("confidence");
+  uint32_t minReps = sweep.GetOption ("min-reps");
+  uint32_t maxReps = sweep.GetOption ("max-reps");
+  NS_ABORT_MSG_IF (minReps < 2 || maxReps < minReps, "need 2 <= min-reps <= max-reps");
+
+  std::vector<ReplicationStats> stats (points.size ()); // in samples of GetPairing replications
+  std::vector<uint32_t> wanted (points.size ());
+  std::vector<uint32_t> most (points.size ());
+  for (uint32_t p = 0; p < points.size (); p++)
+    {
+      uint32_t per = GetPairing (points[p]);
+      wanted[p] = std::max (2u, (minReps + per - 1) / per);
+      most[p] = std::max (wanted[p], maxReps / per);
+    }
+  while (true)
+    {
+      std::vector<TrialSpec> batch;
+      std::vector<uint32_t> owner;
+      for (uint32_t p = 0; p < points.size (); p++)
+        {
+          uint32_t per = GetPairing (points[p]);
+          for (uint32_t k = stats[p].GetN () * per; k < wanted[p] * per; k++)
+            {
+              batch.push_back (sweep.GetReplication (points[p], k));
+              owner.push_back (p);
+            }
+        }
+      if (batch.empty ())
+        {
+          break;
+        }
+
+      std::vector<TrialResult> results = runner.Run (batch);
+      std::vector<std::vector<double> > values (points.size ());
+      for (uint32_t i = 0; i < results.size (); i++)
+        {
+          values[owner[i]].push_back (results[i].throughput);
+        }
+      for (uint32_t p = 0; p < points.size (); p++)
+        {
+          AddSamples (stats[p], points[p], values[p]);
+          wanted[p] = std::min (most[p], stats[p].GetWanted (target, confidence));
+        }
+    }
+  return stats;
+}
+
+// every seed and run of each point, point by point
+inline std::vector<TrialSpec>
+ExpandReplications (const SweepSpec &sweep, const std::vector<TrialSpec> &points)
+{
+  const std::vector<std::string> &seeds = sweep.GetValues ("seed");
+  std::vector<TrialSpec> trials;
+  for (uint32_t p = 0; p < points.size (); p++)
+    {
+      std::vector<std::string> runs = sweep.GetRuns (points[p]);
+      for (uint32_t s = 0; s < seeds.size (); s++)
+        {
+          for (uint32_t r = 0; r < runs.size (); r++)
+            {
+              TrialSpec spec = points[p];
+              spec.Set ("seed", seeds[s]);
+              spec.Set ("run", runs[r]);
+              trials.push_back (spec);
+            }
+        }
+    }
+  return trials;
+}
+
+// all of each point's replications: sequentially stopped with ci-target, otherwise every seed and run
+inline std::vector<ReplicationStats>
+EvaluatePoints (const SweepSpec &sweep, const std::vector<TrialSpec> &points, TrialRunner &runner)
+{
+  if (sweep.GetOption ("ci-target") > 0)
+    {
+      return RunAdaptive (sweep, points, runner);
+    }
+  std::vector<TrialSpec> trials = ExpandReplications (sweep, points);
+  return SummarizePoints (trials, runner.Run (trials));
+}
+
+// what the saturation search found for one point; rates are offered load per flow, Kib/s
+struct SaturationPoint
+{
+  double capacity;   // highest rate found whose mean loss is within the threshold; 0 if not even min-rate's is
+  double throughput; // mean throughput there
+  double loss;       // mean loss rate there
+  double saturated;  // mean throughput at max-rate
+  double saturatedLoss;
+};
+
+/*
+ * Runs every point at the given per-flow rates (every seed and run of
+ * each) and averages throughput and loss over the replications.
+ */
+inline void
+EvaluateLoad (const SweepSpec &sweep, const std::vector<TrialSpec> &points, const std::vector<double> &rates,
+              TrialRunner &runner, std::vector<double> &throughput, std::vector<double> &loss)
+{
+  std::vector<TrialSpec> loaded = points;
+  for (uint32_t p = 0; p < loaded.size (); p++)
+    {
+      loaded[p].Set ("data-rate", FormatNumber (rates[p]) + "Kib/s");
+    }
+  std::vector<TrialSpec> trials = ExpandReplications (sweep, loaded);
+  std::vector<TrialResult> results = runner.Run (trials);
+  throughput.assign (loaded.size (), 0.0);
+  loss.assign (loaded.size (), 0.0);
+  uint32_t i = 0;
+  for (uint32_t p = 0; p < loaded.size (); p++)
+    {
+      uint32_t reps = sweep.GetValues ("seed").size () * sweep.GetRuns (loaded[p]).size (); // antithetic points run whole pairs
+      for (uint32_t r = 0; r < reps; r++, i++)
+        {
+          throughput[p] += results[i].throughput / reps;
+          loss[p] += results[i].GetLossRate () / reps;
+        }
+    }
+}
+
+/*
+ * Saturation search: for every point, the highest per-flow offered rate
+ * between min-rate and max-rate whose mean loss stays within "saturate",
+ * found by bisecting on a log scale until the bracket is within rate-tol
+ * of its lower end.  Loss is taken to grow with offered load.  All points
+ * bisect in lockstep, so each round's trials go to the pool together.
+ * max-rate itself is always run, for the throughput of the saturated cell.
+ */
+inline std::vector<SaturationPoint>
+RunSaturation (const SweepSpec &sweep, const std::vector<TrialSpec> &points, TrialRunner &runner)
+{
+  double threshold = sweep.GetOption ("saturate");
+  double minRate = sweep.GetOption ("min-rate");
+  double maxRate = sweep.GetOption ("max-rate");
+  double tolerance = sweep.GetOption ("rate-tol");
+  NS_ABORT_MSG_UNLESS (0 < minRate && minRate < maxRate && tolerance > 0, "need 0 < min-rate < max-rate and rate-tol > 0");
+
+  NS_ABORT_MSG_IF (sweep.GetValues ("data-rate").size () > 1, "saturate searches the data rate, so it cannot be an axis too");
+
+  uint32_t n = points.size ();
+  std::vector<double> throughput;
+  std::vector<double> loss;
+  std::vector<SaturationPoint> found (n);
+  std::vector<double> lo (n, minRate);
+  std::vector<double> hi (n, maxRate);
+  std::vector<TrialSpec> ends (points);
+  ends.insert (ends.end (), points.begin (), points.end ());
+  std::vector<double> endRates (hi);
+  endRates.insert (endRates.end (), lo.begin (), lo.end ());
+  EvaluateLoad (sweep, ends, endRates, runner, throughput, loss); // max-rate, then min-rate
+  for (uint32_t p = 0; p < n; p++)
+    {
+      found[p].saturated = throughput[p];
+      found[p].saturatedLoss = loss[p];
+      uint32_t at = p;
+      if (loss[p] <= threshold)
+        {
+          lo[p] = maxRate; // no loss to speak of anywhere in range
+        }
+      else
+        {
+          at = n + p;
+          hi[p] = loss[at] <= threshold ? maxRate : minRate;
+        }
+      found[p].capacity = loss[at] <= threshold ? endRates[at] : 0;
+      found[p].throughput = throughput[at];
+      found[p].loss = loss[at];
+    }
+
+  while (true)
+    {
+      std::vector<TrialSpec> active;
+      std::vector<double> mid;
+      std::vector<uint32_t> owner;
+      for (uint32_t p = 0; p < points.size (); p++)
+        {
+          if (hi[p] > lo[p] * (1 + tolerance))
+            {
+              active.push_back (points[p]);
+              mid.push_back (sqrt (lo[p] * hi[p]));
+              owner.push_back (p);
+            }
+        }
+      if (active.empty ())
+        {
+          break;
+        }
+      EvaluateLoad (sweep, active, mid, runner, throughput, loss);
+      for (uint32_t k = 0; k < active.size (); k++)
+        {
+          uint32_t p = owner[k];
+          if (loss[k] <= threshold)
+            {
+              lo[p] = mid[k];
+              found[p].capacity = mid[k];
+              found[p].throughput = throughput[k];
+              found[p].loss = loss[k];
+            }
+          else
+            {
+              hi[p] = mid[k];
+            }
+        }
+    }
+  return found;
+}
+
+// one point of a refined curve; curves sort by group, then by row value
+struct RefinedPoint
+{
+  uint32_t group;
+  double x;
+  TrialSpec spec;
+  ReplicationStats stats;
+
+  bool operator< (const RefinedPoint &other) const;
+};
+
+inline bool
+RefinedPoint::operator< (const RefinedPoint &other) const
+{
+  return group != other.group ? group < other.group : x < other.x;
+}
+
+/*
+ * +1 or -1 if throughput clearly rises or falls from point i to i + 1,
+ * 0 if the change is within the two points' confidence intervals (always
+ * the case with a single replication).
+ */
+inline int
+GetTrend (const std::vector<RefinedPoint> &curve, uint32_t i, double confidence)
+{
+  double change = curve[i + 1].stats.GetMean () - curve[i].stats.GetMean ();
+  double noise = curve[i].stats.GetHalfWidth (confidence) + curve[i + 1].stats.GetHalfWidth (confidence);
+  if (!(fabs (change) > noise))
+    {
+      return 0;
+    }
+  return change > 0 ? 1 : -1;
+}
+
+// interval i jumps by more than threshold, or the curve turns around at one of its ends
+inline bool
+NeedsBisecting (const std::vector<RefinedPoint> &curve, uint32_t i, double threshold, double confidence)
+{
+  if (fabs (curve[i + 1].stats.GetMean () - curve[i].stats.GetMean ()) > threshold)
+    {
+      return true;
+    }
+  int trend = GetTrend (curve, i, confidence);
+  if (trend == 0)
+    {
+      return false;
+    }
+  if (i > 0 && curve[i - 1].group == curve[i].group && GetTrend (curve, i - 1, confidence) == -trend)
+    {
+      return true;
+    }
+  return i + 2 < curve.size () && curve[i + 2].group == curve[i].group
+         && GetTrend (curve, i + 1, confidence) == -trend;
+}
+
+/*
+ * Grid refinement along the row axis: the sweep's row values are only the
+ * starting grid of each group's curve.  Every round bisects each interval
+ * NeedsBisecting flags, as long as both halves stay at least min-step wide,
+ * and simulates all the new midpoints together; it stops when no interval
+ * is flagged.  Integer keys (stations) round the midpoint down.  On return
+ * points holds every simulated point, in PrintTable's order.
+ */
+inline std::vector<ReplicationStats>
+RunRefined (const SweepSpec &sweep, std::vector<TrialSpec> &points, TrialRunner &runner)
+{
+  double threshold = sweep.GetOption ("refine");
+  double minStep = sweep.GetOption ("min-step");
+  double confidence = sweep.GetOption ("confidence");
+  std::string row = sweep.GetRowKey ();
+  NS_ABORT_MSG_UNLESS (minStep > 0, "min-step must be positive");
+
+  std::vector<ReplicationStats> stats = EvaluatePoints (sweep, points, runner);
+  std::vector<RefinedPoint> curve (points.size ());
+  for (uint32_t p = 0; p < points.size (); p++)
+    {
+      curve[p].group = p == 0 ? 0 : curve[p - 1].group
+        + (sweep.GetGroupLabel (points[p]) != sweep.GetGroupLabel (points[p - 1]));
+      curve[p].x = ParseNumber (row, points[p].Get (row));
+      curve[p].spec = points[p];
+      curve[p].stats = stats[p];
+    }
+  std::stable_sort (curve.begin (), curve.end ());
+
+  while (true)
+    {
+      std::vector<RefinedPoint> added;
+      for (uint32_t i = 0; i + 1 < curve.size (); i++)
+        {
+          if (curve[i].group != curve[i + 1].group || !NeedsBisecting (curve, i, threshold, confidence))
+            {
+              continue;
+            }
+          RefinedPoint mid = curve[i];
+          mid.spec.Set (row, FormatNumber ((curve[i].x + curve[i + 1].x) / 2));
+          mid.x = ParseNumber (row, mid.spec.Get (row));
+          if (mid.x - curve[i].x >= minStep && curve[i + 1].x - mid.x >= minStep)
+            {
+              added.push_back (mid);
+            }
+        }
+      if (added.empty ())
+        {
+          break;
+        }
+
+      std::vector<TrialSpec> specs;
+      for (uint32_t k = 0; k < added.size (); k++)
+        {
+          specs.push_back (added[k].spec);
+        }
+      std::vector<ReplicationStats> addedStats = EvaluatePoints (sweep, specs, runner);
+      for (uint32_t k = 0; k < added.size (); k++)
+        {
+          added[k].stats = addedStats[k];
+          curve.push_back (added[k]);
+        }
+      std::stable_sort (curve.begin (), curve.end ());
+    }
+
+  points.clear ();
+  stats.clear ();
+  for (uint32_t p = 0; p < curve.size (); p++)
+    {
+      points.push_back (curve[p].spec);
+      stats.push_back (curve[p].stats);
+    }
+  return stats;
+}
+
+/*
+ * Prints the per-point mean throughput in the layout the results
+ * spreadsheets were pasted from: a heading per group, then one
+ * "<Row>: <value>\t<mean>" line per row.  With detail set, each line also
+ * carries the std-dev, the CI half-width and the number of replications.
+ * Relies on Expand's ordering.
+ */
+inline void
+PrintTable (const SweepSpec &sweep, const std::vector<TrialSpec> &points,
+            const std::vector<ReplicationStats> &stats, bool detail, FILE *out)
+{
+  std::string row = sweep.GetRowKey ();
+  double confidence = sweep.GetOption ("confidence");
+  std::string group;
+  for (uint32_t p = 0; p < points.size (); p++)
+    {
+      std::string label = sweep.GetGroupLabel (points[p]);
+      if (p == 0 || label != group)
+        {
+          group = label;
+          fprintf (out, "%s\n", group.c_str ());
+        }
+      fprintf (out, "%s: %s\t%f", GetRowName (row).c_str (), points[p].Get (row).c_str (), stats[p].GetMean ());
+      if (detail)
+        {
+          fprintf (out, "\t%f\t%f\t%u", stats[p].GetStdDev (), stats[p].GetHalfWidth (confidence), stats[p].GetN ());
+        }
+      fprintf (out, "\n");
+    }
+}
+
+/*
+ * The paired comparison of a fixed sweep: for every point of the pair
+ * key's first value, the throughput difference to the same point of the
+ * second value, seed by seed and run by run.  Paired trials share their
+ * placement, start times and initial fading draws, so the differences
+ * vary far less than the two means do, and the interval is the one of
+ * the mean difference.  It is only exact draw for draw until the two
+ * trials first transmit differently; from then on each consumes the
+ * fading stream at its own pace.
+ */
+inline void
+PrintPaired (const SweepSpec &sweep, const std::vector<TrialSpec> &trials,
+             const std::vector<TrialResult> &results, FILE *out)
+{
+  std::string pair = sweep.GetPairKey ();
+  const std::vector<std::string> &values = sweep.GetValues (pair);
+  std::map<std::string, double> second; // trials of the second value, by their spec with the first value
+  for (uint32_t i = 0; i < trials.size (); i++)
+    {
+      if (trials[i].Get (pair) == values[1])
+        {
+          TrialSpec first = trials[i];
+          first.Set (pair, values[0]);
+          second[first.ToString ()] = results[i].throughput;
+        }
+    }
+
+  std::string row = sweep.GetRowKey ();
+  double confidence = sweep.GetOption ("confidence");
+  std::vector<TrialSpec> points;
+  std::vector<std::vector<double> > differences;
+  for (uint32_t i = 0; i < trials.size (); i++)
+    {
+      if (trials[i].Get (pair) != values[0])
+        {
+          continue;
+        }
+      std::map<std::string, double>::const_iterator j = second.find (trials[i].ToString ());
+      NS_ABORT_MSG_IF (j == second.end (), "no " << pair << "=" << values[1] << " trial to pair with " << trials[i].ToString ());
+      if (points.empty () || trials[i].GetPointKey () != points.back ().GetPointKey ())
+        {
+          points.push_back (trials[i]);
+          differences.push_back (std::vector<double> ());
+        }
+      differences.back ().push_back (results[i].throughput - j->second);
+    }
+  std::vector<ReplicationStats> stats (points.size ());
+  for (uint32_t p = 0; p < points.size (); p++)
+    {
+      AddSamples (stats[p], points[p], differences[p]);
+    }
+
+  fprintf (out, "Paired %s=%s minus %s=%s\n", pair.c_str (), values[0].c_str (), pair.c_str (), values[1].c_str ());
+  std::string group;
+  for (uint32_t p = 0; p < points.size (); p++)
+    {
+      TrialSpec other = points[p];
+      other.Set (pair, values[1]);
+      std::string label = sweep.GetGroupLabel (points[p]) + " - " + sweep.GetGroupLabel (other);
+      if (p == 0 || label != group)
+        {
+          group = label;
+          fprintf (out, "%s\n", group.c_str ());
+        }
+      fprintf (out, "%s: %s\t%f\t%f\t%u\n", GetRowName (row).c_str (), points[p].Get (row).c_str (),
+               stats[p].GetMean (), stats[p].GetHalfWidth (confidence), stats[p].GetN ());
+    }
+}
+
+// per row: capacity, loss and throughput there, then throughput and loss at max-rate
+inline void
+PrintSaturation (const SweepSpec &sweep, const std::vector<TrialSpec> &points,
+                 const std::vector<SaturationPoint> &found, FILE *out)
+{
+  std::string row = sweep.GetRowKey ();
+  std::string group;
+  fprintf (out, "Capacity in Kib/s per flow at loss <= %s\n", FormatNumber (sweep.GetOption ("saturate")).c_str ());
+  for (uint32_t p = 0; p < points.size (); p++)
+    {
+      std::string label = sweep.GetGroupLabel (points[p]);
+      if (p == 0 || label != group)
+        {
+          group = label;
+          fprintf (out, "%s\n", group.c_str ());
+        }
+      fprintf (out, "%s: %s\t%f\t%f\t%f\t%f\t%f\n", GetRowName (row).c_str (), points[p].Get (row).c_str (),
+               found[p].capacity, found[p].loss, found[p].throughput, found[p].saturated, found[p].saturatedLoss);
+    }
+}
+
+// per row: mean loss rate, then delay and jitter percentiles in ms over all replications
+inline void
+PrintLatency (const SweepSpec &sweep, const std::vector<TrialSpec> &points, const TrialRunner &runner, FILE *out)
+{
+  std::string row = sweep.GetRowKey ();
+  std::string group;
+  fprintf (out, "Loss, delay p50/p95/p99 and jitter p50/p95/p99 in ms\n");
+  for (uint32_t p = 0; p < points.size (); p++)
+    {
+      std::string label = sweep.GetGroupLabel (points[p]);
+      if (p == 0 || label != group)
+        {
+          group = label;
+          fprintf (out, "%s\n", group.c_str ());
+        }
+      PointLatency latency = runner.GetLatency (points[p]);
+      fprintf (out, "%s: %s\t%f\t%f\t%f\t%f\t%f\t%f\t%f\n", GetRowName (row).c_str (), points[p].Get (row).c_str (),
+               latency.loss.GetMean (),
+               latency.delays.GetQuantile (0.50) * 1e3, latency.delays.GetQuantile (0.95) * 1e3,
+               latency.delays.GetQuantile (0.99) * 1e3, latency.jitters.GetQuantile (0.50) * 1e3,
+               latency.jitters.GetQuantile (0.95) * 1e3, latency.jitters.GetQuantile (0.99) * 1e3);
+    }
+}
+
+// the log shard i of n keeps its results in, inside the cache directory
+inline std::string
+GetShardFile (uint32_t i, uint32_t n)
+{
+  std::ostringstream os;
+  os << "shard-" << i << "-of-" << n << ".log";
+  return os.str ();
+}
+
+// trial k of the expanded sweep belongs to shard k % n, which spreads every axis over all shards
+inline std::vector<TrialSpec>
+GetShard (const std::vector<TrialSpec> &trials, uint32_t i, uint32_t n)
+{
+  std::vector<TrialSpec> shard;
+  for (uint32_t k = i; k < trials.size (); k += n)
+    {
+      shard.push_back (trials[k]);
+    }
+  return shard;
+}
+
+/*
+ * Collects the results of trials, the whole expanded sweep, from the n
+ * shard logs in dir.  Every trial must be in exactly one of them; if any
+ * is missing or in more than one, they are listed on stderr and the merge
+ * fails rather than print a table built from part of the sweep.
+ */
+inline std::vector<TrialResult>
+MergeShards (const std::vector<TrialSpec> &trials, const std::string &dir, uint32_t n)
+{
+  std::vector<ResultCache *> shards;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      shards.push_back (new ResultCache (dir, GetShardFile (i, n)));
+    }
+  std::vector<TrialResult> results;
+  uint32_t bad = 0;
+  for (uint32_t t = 0; t < trials.size (); t++)
+    {
+      std::string result;
+      uint32_t found = 0;
+      for (uint32_t i = 0; i < n; i++)
+        {
+          std::string r;
+          if (shards[i]->Lookup (trials[t], r))
+            {
+              result = r;
+              found++;
+            }
+        }
+      if (found != 1)
+        {
+          fprintf (stderr, "merge: trial %s is in %u shards\n", trials[t].ToString ().c_str (), found);
+          bad++;
+        }
+      results.push_back (TrialResult::Parse (result));
+    }
+  for (uint32_t i = 0; i < n; i++)
+    {
+      delete shards[i];
+    }
+  NS_ABORT_MSG_IF (bad > 0, bad << " of " << trials.size () << " trials are not in exactly one shard");
+  return results;
+}
+
+/*
+ * The whole of an experiment driver's main: sweep holds the driver's
+ * preset axes, which --config and then --<key> options override.
+ * --trial runs one trial in-process and prints its result line, for
+ * batch schedulers that farm out trials themselves.  The table goes to
+ * stdout and a summary of where the time went to stderr.  With latency
+ * set, each point's loss, delay and jitter percentiles follow the table,
+ * and with a pair key, the paired comparison.  With saturate, the table
+ * is the saturation search's instead (see RunSaturation).  --progress (on
+ * by default when stderr is a terminal) and --status report how far the
+ * sweep has got (see sweep-progress.h).
+ *
+ * For hosts that share only a filesystem, --shard=i/n runs every n-th
+ * trial of a fixed sweep, starting at trial i, into its own log in the
+ * --cache directory (O_APPEND is not atomic over NFS, so shards never
+ * share a file); rerunning a shard resumes it.  Once all shards are done,
+ * --merge=n with the same sweep and cache prints the whole sweep's table.
+ *
+ * --serve and --socket turn the driver into a trial server instead (see
+ * trial-server.h); the sweep options are then ignored.
+ */
+inline int
+SweepMain (SweepSpec &sweep, int argc, char *argv[])
+{
+  uint32_t jobs = SweepRunner::GetDefaultJobs ();
+  std::string config;
+  std::string trial;
+  std::string cacheDir;
+  std::string ns3Version = Ns3Version (); // the build's, if it set one
+  std::string output;
+  std::string shard;
+  uint32_t merge = 0;
+  bool serve = false;
+  std::string socketPath;
+  bool progress = isatty (fileno (stderr));
+  std::string status;
+
+  CommandLine cmd;
+  cmd.AddValue ("jobs", "Number of trials simulated in parallel (0 runs them in-process, for debugging)", jobs);
+  cmd.AddValue ("config", "File of \"key = values\" lines applied before the other options", config);
+  cmd.AddValue ("trial", "Run the single trial given as \"key=value ...\" and print its result", trial);
+  cmd.AddValue ("cache", "Directory of cached trial results; cached trials are skipped and new ones added (needs --ns3-version)", cacheDir);
+  cmd.AddValue ("ns3-version", "ns-3 release these drivers are built against, e.g. ns-3.19; part of every cache key", ns3Version);
+  cmd.AddValue ("output", "Stream one record per trial to this file (.csv, otherwise JSON lines)", output);
+  cmd.AddValue ("shard", "Run only shard \"i/n\" of a fixed sweep, into a log of its own in --cache", shard);
+  cmd.AddValue ("merge", "Print the table of a sweep run as this many shards, from their logs in --cache", merge);
+  cmd.AddValue ("serve", "Run trials requested as lines on stdin, answering on stdout, until end of input", serve);
+  cmd.AddValue ("socket", "Run trials requested by clients of this Unix socket, until killed", socketPath);
+  cmd.AddValue ("progress", "Report progress and an ETA on stderr (default: when stderr is a terminal)", progress);
+  cmd.AddValue ("status", "Keep the latest progress report in this file", status);
+  sweep.AddCommandLine (cmd);
+  cmd.Parse (argc, argv);
+  SetNs3Version (ns3Version);
+
+  if (!config.empty ())
+    {
+      sweep.Load (config);
+    }
+  sweep.ApplyCommandLine ();
+
+  if (!trial.empty ())
+    {
+      printf ("%s\n", RunTrial (TrialSpec::Parse (trial)).ToString ().c_str ());
+      return 0;
+    }
+  if (serve || !socketPath.empty ())
+    {
+      TrialServer server (jobs);
+      ResultCache *cache = cacheDir.empty () ? 0 : new ResultCache (cacheDir);
+      server.SetCache (cache);
+      if (socketPath.empty ())
+        {
+          fflush (stdout);
+          server.ServeStream (0, 1);
+        }
+      else
+        {
+          server.ServeSocket (socketPath);
+        }
+      delete cache;
+      return 0;
+    }
+
+  bool adaptive = sweep.GetOption ("ci-target") > 0;
+  bool refine = sweep.GetOption ("refine") > 0;
+  bool paired = !sweep.GetPairKey ().empty ();
+  bool saturate = sweep.GetOption ("saturate") > 0;
+  NS_ABORT_MSG_IF (saturate && (adaptive || refine || paired || !shard.empty () || merge > 0),
+                   "saturate runs a search of its own; it does not combine with ci-target, refine, pair or sharding");
+  if (paired)
+    {
+      NS_ABORT_MSG_IF (adaptive || refine, "pair compares the trials of a fixed sweep; ci-target and refine choose them by result");
+      NS_ABORT_MSG_IF (sweep.GetValues (sweep.GetPairKey ()).size () != 2 || sweep.GetPairKey () == sweep.GetRowKey (),
+                       "pair must name a two-valued axis other than the rows");
+    }
+  uint32_t shardIndex = 0;
+  uint32_t shardCount = 0;
+  if (!shard.empty () || merge > 0)
+    {
+      NS_ABORT_MSG_IF (cacheDir.empty (), "--shard and --merge need --cache, where the shard logs live");
+      NS_ABORT_MSG_IF (adaptive || refine, "only fixed sweeps can be sharded; which trials an adaptive sweep runs depends on results");
+    }
+  if (merge > 0)
+    {
+      std::vector<TrialSpec> trials = sweep.Expand ();
+      std::vector<TrialResult> results = MergeShards (trials, cacheDir, merge);
+      PrintTable (sweep, sweep.ExpandPoints (), SummarizePoints (trials, results), false, stdout);
+      if (paired)
+        {
+          PrintPaired (sweep, trials, results, stdout);
+        }
+      return 0;
+    }
+  if (!shard.empty ())
+    {
+      char slash = 0;
+      std::istringstream is (shard);
+      is >> shardIndex >> slash >> shardCount;
+      NS_ABORT_MSG_IF (!is || slash != '/' || shardCount == 0 || shardIndex >= shardCount,
+                       "--shard expects i/n with 0 <= i < n, got \"" << shard << "\"");
+    }
+
+  TrialRunner runner (jobs);
+  runner.SetBatch (sweep.GetOption ("batch"));
+  ResultCache *cache = 0;
+  if (!cacheDir.empty ())
+    {
+      cache = shardCount ? new ResultCache (cacheDir, GetShardFile (shardIndex, shardCount)) : new ResultCache (cacheDir);
+      runner.SetCache (cache);
+    }
+  TrialWriter *writer = 0;
+  if (!output.empty ())
+    {
+      writer = new TrialWriter (output);
+      runner.SetWriter (writer);
+    }
+  SweepProgress *reporter = 0;
+  if (progress || !status.empty ())
+    {
+      reporter = new SweepProgress (sweep, progress ? stderr : 0, status);
+      runner.SetProgress (reporter);
+    }
+
+  if (shardCount)
+    {
+      std::vector<TrialSpec> trials = GetShard (sweep.Expand (), shardIndex, shardCount);
+      runner.Run (trials);
+      if (reporter)
+        {
+          reporter->Stop ();
+        }
+      delete reporter;
+      delete writer;
+      delete cache;
+      fprintf (stderr, "shard %u/%u: %u trials done\n", shardIndex, shardCount, (uint32_t)trials.size ());
+      runner.GetCost ().Print (sweep, 5, stderr);
+      return 0;
+    }
+
+  std::vector<TrialSpec> points = sweep.ExpandPoints ();
+  if (saturate)
+    {
+      std::vector<SaturationPoint> found = RunSaturation (sweep, points, runner);
+      if (reporter)
+        {
+          reporter->Stop ();
+        }
+      delete reporter;
+      delete writer;
+      delete cache;
+      PrintSaturation (sweep, points, found, stdout);
+      runner.GetCost ().Print (sweep, 5, stderr);
+      return 0;
+    }
+  std::vector<ReplicationStats> stats;
+  std::vector<TrialSpec> trials;
+  std::vector<TrialResult> results;
+  if (refine)
+    {
+      stats = RunRefined (sweep, points, runner);
+    }
+  else if (paired)
+    {
+      trials = sweep.Expand (); // the same trials EvaluatePoints runs, kept for pairing
+      results = runner.Run (trials);
+      stats = SummarizePoints (trials, results);
+    }
+  else
+    {
+      stats = EvaluatePoints (sweep, points, runner);
+    }
+  if (reporter)
+    {
+      reporter->Stop ();
+    }
+  delete reporter;
+  delete writer;
+  delete cache;
+  PrintTable (sweep, points, stats, adaptive, stdout);
+  if (sweep.GetOption ("latency") > 0)
+    {
+      PrintLatency (sweep, points, runner, stdout);
+    }
+  if (paired)
+    {
+      PrintPaired (sweep, trials, results, stdout);
+    }
+  runner.GetCost ().Print (sweep, 5, stderr); // stdout stays just the table
+  return 0;
+}
+
+} // namespace ns3
+
+#endif /* SWEEP_H */
@@ -0,0 +1,295 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef TRIAL_COST_H
+#define TRIAL_COST_H
+
+#include "ns3/core-module.h"
+
+#include "scenario.h"
+#include "trial-result.h"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <stdio.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+namespace ns3 {
+
+/*
+ * Wraps the real event scheduler (ns3::MapScheduler unless SetInnerType
+ * picks another) and counts the events it hands to the simulator,
+ * cancelled events included, since they are dequeued too.  RunTrial
+ * installs it so that the count works on any ns-3 release, with or without
+ * Simulator::GetEventCount.  The inner type is per process, so a setting
+ * made before the sweep starts carries into every forked trial.
+ */
+class CountingScheduler : public Scheduler
+{
+public:
+  static TypeId GetTypeId (void);
+  static uint64_t GetCount (void);
+  static void ResetCount (void);
+  static void SetInnerType (const std::string &type);
+  static std::string GetInnerType (void);
+
+  CountingScheduler ();
+
+  virtual void Insert (const Scheduler::Event &ev);
+  virtual bool IsEmpty (void) const;
+  virtual Scheduler::Event PeekNext (void) const;
+  virtual Scheduler::Event RemoveNext (void);
+  virtual void Remove (const Scheduler::Event &ev);
+
+private:
+  static uint64_t &Count (void);
+  static std::string &InnerType (void);
+
+  Ptr<Scheduler> m_inner;
+};
+
+inline TypeId
+CountingScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::CountingScheduler")
+    .SetParent<Scheduler> ()
+    .AddConstructor<CountingScheduler> ();
+  return tid;
+}
+
+inline uint64_t &
+CountingScheduler::Count (void)
+{
+  static uint64_t count = 0; // outlives the scheduler, which Simulator::Destroy deletes
+  return count;
+}
+
+inline std::string &
+CountingScheduler::InnerType (void)
+{
+  static std::string type = "ns3::MapScheduler";
+  return type;
+}
+
+inline uint64_t
+CountingScheduler::GetCount (void)
+{
+  return Count ();
+}
+
+inline void
+CountingScheduler::ResetCount (void)
+{
+  Count () = 0;
+}
+
+inline void
+CountingScheduler::SetInnerType (const std::string &type)
+{
+  TypeId tid;
+  NS_ABORT_MSG_UNLESS (TypeId::LookupByNameFailSafe (type, &tid) && tid.IsChildOf (Scheduler::GetTypeId ()),
+                       "\"" << type << "\" is not a scheduler");
+  InnerType () = type;
+}
+
+inline std::string
+CountingScheduler::GetInnerType (void)
+{
+  return InnerType ();
+}
+
+inline
+CountingScheduler::CountingScheduler ()
+{
+  ObjectFactory factory;
+  factory.SetTypeId (InnerType ());
+  m_inner = factory.Create<Scheduler> ();
+}
+
+inline void
+CountingScheduler::Insert (const Scheduler::Event &ev)
+{
+  m_inner->Insert (ev);
+}
+
+inline bool
+CountingScheduler::IsEmpty (void) const
+{
+  return m_inner->IsEmpty ();
+}
+
+inline Scheduler::Event
+CountingScheduler::PeekNext (void) const
+{
+  return m_inner->PeekNext ();
+}
+
+inline Scheduler::Event
+CountingScheduler::RemoveNext (void)
+{
+  Count ()++;
+  return m_inner->RemoveNext ();
+}
+
+inline void
+CountingScheduler::Remove (const Scheduler::Event &ev)
+{
+  m_inner->Remove (ev);
+}
+
+// high-water resident set of this process, KiB (a forked trial starts from the parent's)
+inline uint64_t
+GetPeakRss (void)
+{
+  struct rusage usage;
+  getrusage (RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+/*
+ * Where a sweep's CPU time went: totals over the trials actually simulated
+ * (cached ones cost nothing this time and are only counted), and each
+ * point's share, so the expensive corners of a sweep stand out.  A batch
+ * of trials simulated together has one cost for all its points, so it
+ * counts in the totals but in no point's share.
+ */
+class CostSummary
+{
+public:
+  CostSummary ();
+
+  void Add (const TrialSpec &spec, const TrialResult &result);
+  void AddCached (void);
+  void Print (const SweepSpec &sweep, uint32_t top, FILE *out) const;
+
+private:
+  struct Point
+  {
+    TrialSpec spec;
+    uint32_t trials;
+    double wall;
+    uint64_t events;
+  };
+
+  uint32_t m_trials;
+  uint32_t m_cached;
+  uint32_t m_batched; // simulated in a batch, so in no point's share
+  double m_setup;
+  double m_run;
+  double m_teardown;
+  double m_sim;
+  uint64_t m_events;
+  uint64_t m_peakRss;
+  std::map<std::string, Point> m_points; // by TrialSpec::GetPointKey
+};
+
+inline
+CostSummary::CostSummary ()
+  : m_trials (0),
+    m_cached (0),
+    m_batched (0),
+    m_setup (0.0),
+    m_run (0.0),
+    m_teardown (0.0),
+    m_sim (0.0),
+    m_events (0),
+    m_peakRss (0)
+{
+}
+
+inline void
+CostSummary::Add (const TrialSpec &spec, const TrialResult &result)
+{
+  m_trials++;
+  if (result.costed)
+    {
+      m_setup += result.setupSeconds;
+      m_run += result.runSeconds;
+      m_teardown += result.teardownSeconds;
+      m_sim += result.simSeconds; // once per simulation, batched or not
+      m_events += result.events;
+      m_peakRss = std::max (m_peakRss, result.peakRss);
+    }
+  if (result.batch > 1)
+    {
+      m_batched++;
+      return;
+    }
+
+  std::string key = spec.GetPointKey ();
+  std::map<std::string, Point>::iterator i = m_points.find (key);
+  if (i == m_points.end ())
+    {
+      Point p;
+      p.spec = spec;
+      p.trials = 0;
+      p.wall = 0.0;
+      p.events = 0;
+      i = m_points.insert (std::make_pair (key, p)).first;
+    }
+  i->second.trials++;
+  i->second.wall += result.wallSeconds;
+  i->second.events += result.events;
+}
+
+inline void
+CostSummary::AddCached (void)
+{
+  m_cached++;
+}
+
+inline void
+CostSummary::Print (const SweepSpec &sweep, uint32_t top, FILE *out) const
+{
+  double total = m_setup + m_run + m_teardown;
+  fprintf (out, "cost: %u trials simulated, %u cached\n", m_trials, m_cached);
+  if (m_trials == 0 || total <= 0)
+    {
+      return;
+    }
+  fprintf (out, "cost: %.1f s of trial time: setup %.1f%%, run %.1f%%, teardown %.1f%%\n",
+           total, 100 * m_setup / total, 100 * m_run / total, 100 * m_teardown / total);
+  fprintf (out, "cost: %llu events, %.0f events/s, %.1f simulated s per real s, peak RSS %llu KiB\n",
+           (unsigned long long)m_events, m_run > 0 ? m_events / m_run : 0.0, m_run > 0 ? m_sim / m_run : 0.0,
+           (unsigned long long)m_peakRss);
+  if (m_batched > 0)
+    {
+      fprintf (out, "cost: %u trials shared a simulation with others and are left out of the points below\n", m_batched);
+    }
+
+  std::vector<std::pair<double, const Point *> > byWall;
+  for (std::map<std::string, Point>::const_iterator i = m_points.begin (); i != m_points.end (); ++i)
+    {
+      byWall.push_back (std::make_pair (i->second.wall, &i->second));
+    }
+  std::sort (byWall.rbegin (), byWall.rend ());
+  std::string row = sweep.GetRowKey ();
+  for (uint32_t k = 0; k < byWall.size () && k < top; k++)
+    {
+      const Point &p = *byWall[k].second;
+      fprintf (out, "cost: %5.1f%% %9.1f s %4u trials %10.0f events/s  %s %s=%s\n",
+               100 * p.wall / total, p.wall, p.trials, p.wall > 0 ? p.events / p.wall : 0.0,
+               sweep.GetGroupLabel (p.spec).c_str (), row.c_str (), p.spec.Get (row).c_str ());
+    }
+}
+
+} // namespace ns3
+
+#endif /* TRIAL_COST_H */
@@ -0,0 +1,332 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef TRIAL_OUTPUT_H
+#define TRIAL_OUTPUT_H
+
+#include "ns3/core-module.h"
+
+#include "scenario.h"
+#include "trial-result.h"
+#include "sweep-runner.h"
+
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+
+namespace ns3 {
+
+/*
+ * Streams one record per finished trial to a file, in completion order,
+ * for post-processing instead of scraping the printed table.
+ *
+ * A ".csv" file gets one row per flow, each row repeating the trial's
+ * parameters and cost; anything else gets JSON lines, one object per
+ * trial with its flows in a "flows" array.  The stream is fully buffered
+ * and flushed once per record, so a record is either on disk whole or not
+ * at all once the call returns, and the sweep never waits on a terminal.
+ * Trials simulated together (see RunTrials) share one cost, which only
+ * the first of them reports; the others leave the cost fields empty in
+ * CSV and null in JSON, and "batch" says how many trials shared it.
+ */
+class TrialWriter
+{
+public:
+  TrialWriter (const std::string &filename);
+  ~TrialWriter ();
+
+  void Write (const TrialSpec &spec, const TrialResult &result, bool cached);
+
+private:
+  static std::string Quote (const std::string &s);
+  static std::string Number (double x);
+  static std::string Cost (const TrialResult &result, const std::string &value);
+  static bool IsNumber (const std::string &s);
+  static double GetRate (double amount, double seconds);
+  void WriteCsv (const TrialSpec &spec, const TrialResult &result, bool cached);
+  void WriteJson (const TrialSpec &spec, const TrialResult &result, bool cached);
+
+  FILE *m_file;
+  bool m_csv;
+  uint32_t m_records;
+  std::vector<char> m_buffer;
+};
+
+inline
+TrialWriter::TrialWriter (const std::string &filename)
+  : m_file (0),
+    m_csv (filename.size () >= 4 && filename.compare (filename.size () - 4, 4, ".csv") == 0),
+    m_records (0),
+    m_buffer (1 << 16)
+{
+  m_file = fopen (filename.c_str (), "w");
+  if (!m_file)
+    {
+      NS_FATAL_ERROR ("cannot open \"" << filename << "\": " << strerror (errno));
+    }
+  setvbuf (m_file, &m_buffer[0], _IOFBF, m_buffer.size ());
+  if (m_csv)
+    {
+      const std::vector<std::string> &keys = TrialSpec::GetKeys ();
+      fprintf (m_file, "record");
+      for (uint32_t i = 0; i < keys.size (); i++)
+        {
+          fprintf (m_file, ",%s", keys[i].c_str ());
+        }
+      fprintf (m_file, ",cached,batch,wall,setup-wall,run-wall,teardown-wall,events,events-per-s,sim-per-s,peak-rss,sim,steady-from,culled,throughput,uplink,downlink,loss,"
+               "delay-p50,delay-p95,delay-p99,jitter-p50,jitter-p95,jitter-p99,flow,source,destination,tx-bytes,rx-bytes,tx-packets,"
+               "rx-packets,lost-packets,delay-sum,jitter-sum,first-tx,first-rx,last-tx,last-rx,direction,flow-throughput,"
+               "flow-delay-p50,flow-delay-p95,flow-delay-p99,flow-jitter-p50,flow-jitter-p95,flow-jitter-p99\n");
+      fflush (m_file);
+    }
+}
+
+inline
+TrialWriter::~TrialWriter ()
+{
+  fclose (m_file);
+}
+
+// amount per second of Simulator::Run, 0 for a trial too quick to time
+inline double
+TrialWriter::GetRate (double amount, double seconds)
+{
+  return seconds > 0 ? amount / seconds : 0.0;
+}
+
+inline std::string
+TrialWriter::Quote (const std::string &s)
+{
+  std::string q = "\"";
+  for (std::string::size_type i = 0; i < s.size (); i++)
+    {
+      if (s[i] == '"' || s[i] == '\\')
+        {
+          q += '\\';
+        }
+      q += s[i];
+    }
+  return q + "\"";
+}
+
+// a JSON number, or null for the nan and inf JSON has no literal for
+inline std::string
+TrialWriter::Number (double x)
+{
+  if (x != x || x - x != 0) // nan, or inf
+    {
+      return "null";
+    }
+  return SweepRunner::FormatDouble (x);
+}
+
+// a cost field's value, or null in the records of a batch that carry none of its cost
+inline std::string
+TrialWriter::Cost (const TrialResult &result, const std::string &value)
+{
+  return result.costed ? value : "null";
+}
+
+// whether s is a JSON number literal: -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+inline bool
+TrialWriter::IsNumber (const std::string &s)
+{
+  std::string::size_type i = 0;
+  std::string::size_type n = s.size ();
+  if (i < n && s[i] == '-')
+    {
+      i++;
+    }
+  if (i < n && s[i] == '0')
+    {
+      i++;
+    }
+  else if (i < n && s[i] >= '1' && s[i] <= '9')
+    {
+      while (i < n && isdigit ((unsigned char)s[i]))
+        {
+          i++;
+        }
+    }
+  else
+    {
+      return false;
+    }
+  if (i < n && s[i] == '.')
+    {
+      std::string::size_type start = ++i;
+      while (i < n && isdigit ((unsigned char)s[i]))
+        {
+          i++;
+        }
+      if (i == start)
+        {
+          return false;
+        }
+    }
+  if (i < n && (s[i] == 'e' || s[i] == 'E'))
+    {
+      i++;
+      if (i < n && (s[i] == '+' || s[i] == '-'))
+        {
+          i++;
+        }
+      std::string::size_type start = i;
+      while (i < n && isdigit ((unsigned char)s[i]))
+        {
+          i++;
+        }
+      if (i == start)
+        {
+          return false;
+        }
+    }
+  return i == n;
+}
+
+inline void
+TrialWriter::Write (const TrialSpec &spec, const TrialResult &result, bool cached)
+{
+  if (m_csv)
+    {
+      WriteCsv (spec, result, cached);
+    }
+  else
+    {
+      WriteJson (spec, result, cached);
+    }
+  m_records++;
+  fflush (m_file);
+}
+
+inline void
+TrialWriter::WriteCsv (const TrialSpec &spec, const TrialResult &result, bool cached)
+{
+  const std::vector<std::string> &keys = TrialSpec::GetKeys ();
+  std::string prefix = FormatNumber (m_records);
+  for (uint32_t i = 0; i < keys.size (); i++)
+    {
+      prefix += "," + spec.Get (keys[i]);
+    }
+  prefix += std::string (cached ? ",1," : ",0,") + FormatNumber (result.batch);
+  if (result.costed)
+    {
+      prefix += "," + SweepRunner::FormatDouble (result.wallSeconds)
+        + "," + SweepRunner::FormatDouble (result.setupSeconds)
+        + "," + SweepRunner::FormatDouble (result.runSeconds)
+        + "," + SweepRunner::FormatDouble (result.teardownSeconds)
+        + "," + FormatNumber (result.events)
+        + "," + SweepRunner::FormatDouble (GetRate (result.events, result.runSeconds))
+        + "," + SweepRunner::FormatDouble (GetRate (result.simSeconds, result.runSeconds))
+        + "," + FormatNumber (result.peakRss);
+    }
+  else
+    {
+      prefix += ",,,,,,,,"; // the batch's cost is in its first trial's record
+    }
+  prefix += "," + SweepRunner::FormatDouble (result.simSeconds)
+    + "," + SweepRunner::FormatDouble (result.steadyFrom)
+    + "," + FormatNumber (result.culled)
+    + "," + SweepRunner::FormatDouble (result.throughput)
+    + "," + SweepRunner::FormatDouble (result.uplinkThroughput)
+    + "," + SweepRunner::FormatDouble (result.downlinkThroughput)
+    + "," + SweepRunner::FormatDouble (result.GetLossRate ())
+    + "," + SweepRunner::FormatDouble (result.delays.GetQuantile (0.50))
+    + "," + SweepRunner::FormatDouble (result.delays.GetQuantile (0.95))
+    + "," + SweepRunner::FormatDouble (result.delays.GetQuantile (0.99))
+    + "," + SweepRunner::FormatDouble (result.jitters.GetQuantile (0.50))
+    + "," + SweepRunner::FormatDouble (result.jitters.GetQuantile (0.95))
+    + "," + SweepRunner::FormatDouble (result.jitters.GetQuantile (0.99));
+  if (result.flows.empty ())
+    {
+      fprintf (m_file, "%s,,,,,,,,,,,,,,,,,,,,,,\n", prefix.c_str ());
+    }
+  for (uint32_t f = 0; f < result.flows.size (); f++)
+    {
+      fprintf (m_file, "%s,%u,%s\n", prefix.c_str (), f, result.flows[f].ToString ().c_str ());
+    }
+}
+
+inline void
+TrialWriter::WriteJson (const TrialSpec &spec, const TrialResult &result, bool cached)
+{
+  const std::vector<std::string> &keys = TrialSpec::GetKeys ();
+  fprintf (m_file, "{\"record\":%u", m_records);
+  for (uint32_t i = 0; i < keys.size (); i++)
+    {
+      std::string value = spec.Get (keys[i]);
+      fprintf (m_file, ",%s:%s", Quote (keys[i]).c_str (), (IsNumber (value) ? value : Quote (value)).c_str ());
+    }
+  fprintf (m_file, ",\"cached\":%s,\"batch\":%u,\"wall\":%s,\"setup-wall\":%s,\"run-wall\":%s,\"teardown-wall\":%s,"
+           "\"events\":%s,\"events-per-s\":%s,\"sim-per-s\":%s,\"peak-rss\":%s,\"sim\":%s,\"steady-from\":%s,\"culled\":%llu,\"throughput\":%s,\"uplink\":%s,\"downlink\":%s,"
+           "\"loss\":%s,\"delay-p50\":%s,\"delay-p95\":%s,\"delay-p99\":%s,\"jitter-p50\":%s,\"jitter-p95\":%s,\"jitter-p99\":%s,\"flows\":[",
+           cached ? "true" : "false", result.batch,
+           Cost (result, Number (result.wallSeconds)).c_str (),
+           Cost (result, Number (result.setupSeconds)).c_str (),
+           Cost (result, Number (result.runSeconds)).c_str (),
+           Cost (result, Number (result.teardownSeconds)).c_str (),
+           Cost (result, FormatNumber (result.events)).c_str (),
+           Cost (result, Number (GetRate (result.events, result.runSeconds))).c_str (),
+           Cost (result, Number (GetRate (result.simSeconds, result.runSeconds))).c_str (),
+           Cost (result, FormatNumber (result.peakRss)).c_str (),
+           Number (result.simSeconds).c_str (),
+           Number (result.steadyFrom).c_str (),
+           (unsigned long long)result.culled,
+           Number (result.throughput).c_str (),
+           Number (result.uplinkThroughput).c_str (),
+           Number (result.downlinkThroughput).c_str (),
+           Number (result.GetLossRate ()).c_str (),
+           Number (result.delays.GetQuantile (0.50)).c_str (),
+           Number (result.delays.GetQuantile (0.95)).c_str (),
+           Number (result.delays.GetQuantile (0.99)).c_str (),
+           Number (result.jitters.GetQuantile (0.50)).c_str (),
+           Number (result.jitters.GetQuantile (0.95)).c_str (),
+           Number (result.jitters.GetQuantile (0.99)).c_str ());
+  for (uint32_t f = 0; f < result.flows.size (); f++)
+    {
+      const FlowResult &flow = result.flows[f];
+      fprintf (m_file, "%s{\"source\":%s,\"destination\":%s,\"tx-bytes\":%llu,\"rx-bytes\":%llu,"
+               "\"tx-packets\":%u,\"rx-packets\":%u,\"lost-packets\":%u,\"delay-sum\":%s,\"jitter-sum\":%s,"
+               "\"first-tx\":%s,\"first-rx\":%s,\"last-tx\":%s,\"last-rx\":%s,\"direction\":%s,\"throughput\":%s,"
+               "\"delay-p50\":%s,\"delay-p95\":%s,\"delay-p99\":%s,\"jitter-p50\":%s,\"jitter-p95\":%s,\"jitter-p99\":%s}",
+               f ? "," : "", Quote (flow.source).c_str (), Quote (flow.destination).c_str (),
+               (unsigned long long)flow.txBytes, (unsigned long long)flow.rxBytes,
+               flow.txPackets, flow.rxPackets, flow.lostPackets,
+               Number (flow.delaySum).c_str (),
+               Number (flow.jitterSum).c_str (),
+               Number (flow.timeFirstTxPacket).c_str (),
+               Number (flow.timeFirstRxPacket).c_str (),
+               Number (flow.timeLastTxPacket).c_str (),
+               Number (flow.timeLastRxPacket).c_str (),
+               Quote (flow.direction).c_str (),
+               Number (flow.throughput).c_str (),
+               Number (flow.delayP50).c_str (),
+               Number (flow.delayP95).c_str (),
+               Number (flow.delayP99).c_str (),
+               Number (flow.jitterP50).c_str (),
+               Number (flow.jitterP95).c_str (),
+               Number (flow.jitterP99).c_str ());
+    }
+  fprintf (m_file, "]}\n");
+}
+
+} // namespace ns3
+
+#endif /* TRIAL_OUTPUT_H */
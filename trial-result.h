@@ -0,0 +1,321 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef TRIAL_RESULT_H
+#define TRIAL_RESULT_H
+
+#include "ns3/core-module.h"
+
+#include "sweep-runner.h"
+#include "delay-histogram.h"
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <stdlib.h>
+
+namespace ns3 {
+
+/*
+ * One flow's FlowMonitor counters at the end of a trial.  Times are in
+ * seconds of simulated time; a flow that never received anything has
+ * zero first/last rx times.  throughput is the flow's own receive rate,
+ * see FlowOutput in trial.h.
+ */
+struct FlowResult
+{
+  FlowResult ();
+
+  std::string ToString (void) const;
+  static FlowResult Parse (const std::string &text);
+
+  std::string source;      // sender's IPv4 address
+  std::string destination; // receiver's IPv4 address
+  uint64_t txBytes;
+  uint64_t rxBytes;
+  uint32_t txPackets;
+  uint32_t rxPackets;
+  uint32_t lostPackets;
+  double delaySum;
+  double jitterSum;
+  double timeFirstTxPacket;
+  double timeFirstRxPacket;
+  double timeLastTxPacket;
+  double timeLastRxPacket;
+  std::string direction;   // "uplink" (station to AP) or "downlink"
+  double throughput;       // Kib/s
+  double delayP50;         // one-way delay percentiles, seconds
+  double delayP95;
+  double delayP99;
+  double jitterP50;        // jitter percentiles, seconds
+  double jitterP95;
+  double jitterP99;
+};
+
+/*
+ * What a trial hands back to the sweep.  It crosses the process boundary,
+ * and goes into the result cache, as one line of space separated key=value
+ * fields (with one "flow=" field per flow), so ToString and Parse must
+ * round-trip exactly.  Parse ignores keys it does not know.
+ */
+struct TrialResult
+{
+  TrialResult ();
+
+  std::string ToString (void) const;
+  static TrialResult Parse (const std::string &text);
+  double GetLossRate (void) const; // share of all flows' sent packets never received
+
+  double throughput;  // sum of the flows' throughputs, Kib/s
+  double uplinkThroughput;
+  double downlinkThroughput;
+  double wallSeconds; // real time the trial took, setup to teardown
+  double setupSeconds;    // ... of which building the world
+  double runSeconds;      // ... Simulator::Run
+  double teardownSeconds; // ... collecting results and Simulator::Destroy
+  uint64_t events;    // events the simulator dequeued
+  uint64_t peakRss;   // KiB
+  double simSeconds;  // simulated time the trial ran for; less than duration if it reached steady state
+  double steadyFrom;  // simulated time the steady-state throughput is measured from, 0 without sample
+  uint64_t culled;    // links (transmitter, receiver) the channel left out, see cull
+  uint32_t batch;     // trials simulated together with this one, itself included
+  bool costed;        // whether wall to peakRss hold a cost: a batch's cost is all in its first trial's
+  DelayHistogram delays;  // all flows' one-way delays
+  DelayHistogram jitters; // all flows' jitters
+  std::vector<FlowResult> flows;
+};
+
+inline
+FlowResult::FlowResult ()
+  : txBytes (0),
+    rxBytes (0),
+    txPackets (0),
+    rxPackets (0),
+    lostPackets (0),
+    delaySum (0.0),
+    jitterSum (0.0),
+    timeFirstTxPacket (0.0),
+    timeFirstRxPacket (0.0),
+    timeLastTxPacket (0.0),
+    timeLastRxPacket (0.0),
+    throughput (0.0),
+    delayP50 (0.0),
+    delayP95 (0.0),
+    delayP99 (0.0),
+    jitterP50 (0.0),
+    jitterP95 (0.0),
+    jitterP99 (0.0)
+{
+}
+
+// source,destination,txBytes,rxBytes,txPackets,rxPackets,lostPackets,delaySum,jitterSum,firstTx,firstRx,lastTx,lastRx,direction,throughput,
+// delayP50,delayP95,delayP99,jitterP50,jitterP95,jitterP99
+inline std::string
+FlowResult::ToString (void) const
+{
+  std::ostringstream os;
+  os << source << "," << destination << "," << txBytes << "," << rxBytes << ","
+     << txPackets << "," << rxPackets << "," << lostPackets << ","
+     << SweepRunner::FormatDouble (delaySum) << "," << SweepRunner::FormatDouble (jitterSum) << ","
+     << SweepRunner::FormatDouble (timeFirstTxPacket) << "," << SweepRunner::FormatDouble (timeFirstRxPacket) << ","
+     << SweepRunner::FormatDouble (timeLastTxPacket) << "," << SweepRunner::FormatDouble (timeLastRxPacket) << ","
+     << direction << "," << SweepRunner::FormatDouble (throughput) << ","
+     << SweepRunner::FormatDouble (delayP50) << "," << SweepRunner::FormatDouble (delayP95) << ","
+     << SweepRunner::FormatDouble (delayP99) << "," << SweepRunner::FormatDouble (jitterP50) << ","
+     << SweepRunner::FormatDouble (jitterP95) << "," << SweepRunner::FormatDouble (jitterP99);
+  return os.str ();
+}
+
+inline FlowResult
+FlowResult::Parse (const std::string &text)
+{
+  std::vector<std::string> f;
+  std::istringstream is (text);
+  std::string item;
+  while (std::getline (is, item, ','))
+    {
+      f.push_back (item);
+    }
+  NS_ABORT_MSG_IF (f.size () != 21, "bad flow result \"" << text << "\"");
+  FlowResult flow;
+  flow.source = f[0];
+  flow.destination = f[1];
+  flow.txBytes = strtoull (f[2].c_str (), 0, 10);
+  flow.rxBytes = strtoull (f[3].c_str (), 0, 10);
+  flow.txPackets = strtoul (f[4].c_str (), 0, 10);
+  flow.rxPackets = strtoul (f[5].c_str (), 0, 10);
+  flow.lostPackets = strtoul (f[6].c_str (), 0, 10);
+  flow.delaySum = SweepRunner::ParseDouble (f[7]);
+  flow.jitterSum = SweepRunner::ParseDouble (f[8]);
+  flow.timeFirstTxPacket = SweepRunner::ParseDouble (f[9]);
+  flow.timeFirstRxPacket = SweepRunner::ParseDouble (f[10]);
+  flow.timeLastTxPacket = SweepRunner::ParseDouble (f[11]);
+  flow.timeLastRxPacket = SweepRunner::ParseDouble (f[12]);
+  flow.direction = f[13];
+  flow.throughput = SweepRunner::ParseDouble (f[14]);
+  flow.delayP50 = SweepRunner::ParseDouble (f[15]);
+  flow.delayP95 = SweepRunner::ParseDouble (f[16]);
+  flow.delayP99 = SweepRunner::ParseDouble (f[17]);
+  flow.jitterP50 = SweepRunner::ParseDouble (f[18]);
+  flow.jitterP95 = SweepRunner::ParseDouble (f[19]);
+  flow.jitterP99 = SweepRunner::ParseDouble (f[20]);
+  return flow;
+}
+
+inline
+TrialResult::TrialResult ()
+  : throughput (0.0),
+    uplinkThroughput (0.0),
+    downlinkThroughput (0.0),
+    wallSeconds (0.0),
+    setupSeconds (0.0),
+    runSeconds (0.0),
+    teardownSeconds (0.0),
+    events (0),
+    peakRss (0),
+    simSeconds (0.0),
+    steadyFrom (0.0),
+    culled (0),
+    batch (1),
+    costed (true)
+{
+}
+
+inline std::string
+TrialResult::ToString (void) const
+{
+  std::string s = "throughput=" + SweepRunner::FormatDouble (throughput)
+    + " uplink=" + SweepRunner::FormatDouble (uplinkThroughput)
+    + " downlink=" + SweepRunner::FormatDouble (downlinkThroughput)
+    + " wall=" + SweepRunner::FormatDouble (wallSeconds)
+    + " setup-wall=" + SweepRunner::FormatDouble (setupSeconds)
+    + " run-wall=" + SweepRunner::FormatDouble (runSeconds)
+    + " teardown-wall=" + SweepRunner::FormatDouble (teardownSeconds)
+    + " sim=" + SweepRunner::FormatDouble (simSeconds)
+    + " steady-from=" + SweepRunner::FormatDouble (steadyFrom);
+  std::ostringstream counters;
+  counters << " events=" << events << " peak-rss=" << peakRss << " culled=" << culled
+           << " batch=" << batch << " costed=" << (costed ? 1 : 0);
+  s += counters.str ();
+  s += " delays=" + delays.ToString () + " jitters=" + jitters.ToString ();
+  for (uint32_t i = 0; i < flows.size (); i++)
+    {
+      s += " flow=" + flows[i].ToString ();
+    }
+  return s;
+}
+
+inline double
+TrialResult::GetLossRate (void) const
+{
+  uint64_t tx = 0;
+  uint64_t rx = 0;
+  for (uint32_t i = 0; i < flows.size (); i++)
+    {
+      tx += flows[i].txPackets;
+      rx += flows[i].rxPackets;
+    }
+  return tx > 0 ? 1.0 - (double)rx / tx : 0.0;
+}
+
+inline TrialResult
+TrialResult::Parse (const std::string &text)
+{
+  TrialResult result;
+  std::istringstream is (text);
+  std::string field;
+  while (is >> field)
+    {
+      std::string::size_type eq = field.find ('=');
+      NS_ABORT_MSG_IF (eq == std::string::npos, "bad trial result field \"" << field << "\"");
+      std::string key = field.substr (0, eq);
+      std::string value = field.substr (eq + 1);
+      if (key == "throughput")
+        {
+          result.throughput = SweepRunner::ParseDouble (value);
+        }
+      else if (key == "uplink")
+        {
+          result.uplinkThroughput = SweepRunner::ParseDouble (value);
+        }
+      else if (key == "downlink")
+        {
+          result.downlinkThroughput = SweepRunner::ParseDouble (value);
+        }
+      else if (key == "wall")
+        {
+          result.wallSeconds = SweepRunner::ParseDouble (value);
+        }
+      else if (key == "setup-wall")
+        {
+          result.setupSeconds = SweepRunner::ParseDouble (value);
+        }
+      else if (key == "run-wall")
+        {
+          result.runSeconds = SweepRunner::ParseDouble (value);
+        }
+      else if (key == "teardown-wall")
+        {
+          result.teardownSeconds = SweepRunner::ParseDouble (value);
+        }
+      else if (key == "events")
+        {
+          result.events = strtoull (value.c_str (), 0, 10);
+        }
+      else if (key == "peak-rss")
+        {
+          result.peakRss = strtoull (value.c_str (), 0, 10);
+        }
+      else if (key == "sim")
+        {
+          result.simSeconds = SweepRunner::ParseDouble (value);
+        }
+      else if (key == "steady-from")
+        {
+          result.steadyFrom = SweepRunner::ParseDouble (value);
+        }
+      else if (key == "culled")
+        {
+          result.culled = strtoull (value.c_str (), 0, 10);
+        }
+      else if (key == "batch")
+        {
+          result.batch = strtoul (value.c_str (), 0, 10);
+        }
+      else if (key == "costed")
+        {
+          result.costed = value == "1";
+        }
+      else if (key == "delays")
+        {
+          result.delays = DelayHistogram::Parse (value);
+        }
+      else if (key == "jitters")
+        {
+          result.jitters = DelayHistogram::Parse (value);
+        }
+      else if (key == "flow")
+        {
+          result.flows.push_back (FlowResult::Parse (value));
+        }
+    }
+  return result;
+}
+
+} // namespace ns3
+
+#endif /* TRIAL_RESULT_H */
@@ -0,0 +1,483 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+
+#ifndef TRIAL_SERVER_H
+#define TRIAL_SERVER_H
+
+#include "ns3/core-module.h"
+
+#include "scenario.h"
+#include "trial.h"
+#include "result-cache.h"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <deque>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+namespace ns3 {
+
+/*
+ * Runs trials on request, so that ad-hoc sweeps pay for process start-up,
+ * dynamic linking and TypeId registration once instead of per sweep.
+ *
+ * Requests are lines of "key=value ..." (a TrialSpec, as --trial takes),
+ * read from stdin or from any number of clients of a Unix socket.  Each
+ * is answered on the connection it came in on, as soon as it finishes, by
+ * "<n> <result>" where n counts the requests on that connection from 1,
+ * or "<n> error <why>" if the trial died (a bad key, say).
+ *
+ * "jobs" workers are forked ahead of time and wait for a request; a worker
+ * runs exactly one trial, so the Simulator singleton is always fresh, and
+ * is replaced by a new one the moment it finishes.  With a cache, a
+ * worker answers cached trials without simulating and adds new results;
+ * being forked ahead of time, it knows the results as of its fork.
+ */
+class TrialServer
+{
+public:
+  TrialServer (uint32_t jobs);
+
+  void SetCache (ResultCache *cache);
+  void ServeStream (int in, int out);         // until in reaches end of file
+  void ServeSocket (const std::string &path); // until killed
+
+private:
+  struct Worker
+  {
+    pid_t pid;
+    int request;
+    int reply;
+    bool busy;
+    uint32_t client;
+    uint32_t seq;
+    std::string buffer;
+  };
+
+  struct Client
+  {
+    int in;
+    int out;
+    bool eof;
+    uint32_t seq;
+    uint32_t pending;
+    std::string buffer;
+  };
+
+  struct Request
+  {
+    uint32_t client;
+    uint32_t seq;
+    std::string line;
+  };
+
+  static void WriteAll (int fd, const std::string &text);
+
+  void Loop (int listener);
+  void StartWorker (int listener);
+  void ReadClient (uint32_t id);
+  void Dispatch (void);
+  void FinishWorker (uint32_t w);
+  void Reply (uint32_t client, uint32_t seq, const std::string &text);
+
+  uint32_t m_jobs;
+  ResultCache *m_cache;
+  std::vector<Worker> m_workers;
+  std::map<uint32_t, Client> m_clients;
+  uint32_t m_nextClient;
+  std::deque<Request> m_queue;
+};
+
+inline
+TrialServer::TrialServer (uint32_t jobs)
+  : m_jobs (jobs > 0 ? jobs : 1),
+    m_cache (0),
+    m_nextClient (0)
+{
+}
+
+inline void
+TrialServer::SetCache (ResultCache *cache)
+{
+  m_cache = cache;
+}
+
+inline void
+TrialServer::WriteAll (int fd, const std::string &text)
+{
+  const char *p = text.data ();
+  size_t left = text.size ();
+  while (left > 0)
+    {
+      ssize_t n = write (fd, p, left);
+      if (n < 0 && errno == EINTR)
+        {
+          continue;
+        }
+      if (n < 0)
+        {
+          return; // the client went away; its answers are dropped
+        }
+      p += n;
+      left -= n;
+    }
+}
+
+inline void
+TrialServer::ServeStream (int in, int out)
+{
+  Client client;
+  client.in = in;
+  client.out = out;
+  client.eof = false;
+  client.seq = 0;
+  client.pending = 0;
+  m_clients[m_nextClient++] = client;
+  Loop (-1);
+}
+
+inline void
+TrialServer::ServeSocket (const std::string &path)
+{
+  signal (SIGPIPE, SIG_IGN); // a client hanging up must not take the server with it
+  int listener = socket (AF_UNIX, SOCK_STREAM, 0);
+  struct sockaddr_un addr;
+  memset (&addr, 0, sizeof (addr));
+  addr.sun_family = AF_UNIX;
+  NS_ABORT_MSG_IF (path.size () >= sizeof (addr.sun_path), "socket path \"" << path << "\" is too long");
+  strcpy (addr.sun_path, path.c_str ());
+  unlink (path.c_str ());
+  if (listener < 0 || bind (listener, (struct sockaddr *)&addr, sizeof (addr)) < 0 || listen (listener, 16) < 0)
+    {
+      NS_FATAL_ERROR ("cannot listen on \"" << path << "\": " << strerror (errno));
+    }
+  Loop (listener);
+}
+
+inline void
+TrialServer::StartWorker (int listener)
+{
+  int request[2];
+  int reply[2];
+  if (pipe (request) < 0 || pipe (reply) < 0)
+    {
+      NS_FATAL_ERROR ("pipe failed: " << strerror (errno));
+    }
+  fflush (0);
+  pid_t pid = fork ();
+  if (pid < 0)
+    {
+      NS_FATAL_ERROR ("fork failed: " << strerror (errno));
+    }
+  if (pid == 0)
+    {
+      close (request[1]);
+      close (reply[0]);
+      if (listener >= 0)
+        {
+          close (listener);
+        }
+      for (uint32_t i = 0; i < m_workers.size (); i++)
+        {
+          close (m_workers[i].request);
+          close (m_workers[i].reply);
+        }
+      for (std::map<uint32_t, Client>::iterator c = m_clients.begin (); listener >= 0 && c != m_clients.end (); ++c)
+        {
+          close (c->second.in); // or the client would not see the server hang up until this trial ends
+        }
+      std::string line;
+      char buf[4096];
+      ssize_t n;
+      while ((n = read (request[0], buf, sizeof (buf))) != 0)
+        {
+          if (n > 0)
+            {
+              line.append (buf, n);
+            }
+          else if (errno != EINTR)
+            {
+              _exit (1);
+            }
+        }
+      if (Trim (line).empty ())
+        {
+          _exit (0); // the server is shutting down
+        }
+      TrialSpec spec = TrialSpec::Parse (line); // in here, so that a bad request only kills this worker
+      std::string result;
+      if (!m_cache || !m_cache->Lookup (spec, result))
+        {
+          result = RunTrial (spec).ToString ();
+          if (m_cache)
+            {
+              m_cache->Store (spec, result);
+            }
+        }
+      WriteAll (reply[1], spec.ToString () + "\n" + result); // the canonical spec lets the server remember the result
+      close (reply[1]);
+      fflush (stdout);
+      _exit (0);
+    }
+
+  close (request[0]);
+  close (reply[1]);
+  Worker worker;
+  worker.pid = pid;
+  worker.request = request[1];
+  worker.reply = reply[0];
+  worker.busy = false;
+  worker.client = 0;
+  worker.seq = 0;
+  m_workers.push_back (worker);
+}
+
+inline void
+TrialServer::Reply (uint32_t client, uint32_t seq, const std::string &text)
+{
+  std::map<uint32_t, Client>::iterator c = m_clients.find (client);
+  if (c == m_clients.end ())
+    {
+      return;
+    }
+  std::ostringstream os;
+  os << seq << " " << text << "\n";
+  WriteAll (c->second.out, os.str ());
+  c->second.pending--;
+}
+
+inline void
+TrialServer::ReadClient (uint32_t id)
+{
+  Client &client = m_clients[id];
+  char buf[4096];
+  ssize_t n = read (client.in, buf, sizeof (buf));
+  if (n < 0 && errno == EINTR)
+    {
+      return;
+    }
+  if (n <= 0)
+    {
+      client.eof = true;
+      return;
+    }
+  client.buffer.append (buf, n);
+  std::string::size_type nl;
+  while ((nl = client.buffer.find ('\n')) != std::string::npos)
+    {
+      std::string line = Trim (client.buffer.substr (0, nl));
+      client.buffer.erase (0, nl + 1);
+      if (line.empty ())
+        {
+          continue;
+        }
+      Request request;
+      request.client = id;
+      request.seq = ++client.seq;
+      request.line = line;
+      client.pending++;
+      m_queue.push_back (request);
+    }
+}
+
+inline void
+TrialServer::Dispatch (void)
+{
+  for (uint32_t w = 0; w < m_workers.size () && !m_queue.empty (); w++)
+    {
+      if (m_workers[w].busy)
+        {
+          continue;
+        }
+      Request request = m_queue.front ();
+      m_queue.pop_front ();
+      Worker &worker = m_workers[w];
+      worker.busy = true;
+      worker.client = request.client;
+      worker.seq = request.seq;
+      WriteAll (worker.request, request.line + "\n");
+      close (worker.request); // end of file tells the worker the request is complete
+      worker.request = -1;
+    }
+}
+
+inline void
+TrialServer::FinishWorker (uint32_t w)
+{
+  Worker worker = m_workers[w];
+  m_workers.erase (m_workers.begin () + w);
+  close (worker.reply);
+  int status = 0;
+  while (waitpid (worker.pid, &status, 0) < 0 && errno == EINTR)
+    {
+    }
+  std::string::size_type nl = worker.buffer.find ('\n');
+  if (!WIFEXITED (status) || WEXITSTATUS (status) != 0 || nl == std::string::npos)
+    {
+      std::ostringstream os;
+      os << "error trial process ended with status " << status;
+      Reply (worker.client, worker.seq, os.str ());
+      return;
+    }
+  std::string result = worker.buffer.substr (nl + 1);
+  if (m_cache)
+    {
+      m_cache->Remember (TrialSpec::Parse (worker.buffer.substr (0, nl)), result); // so later workers see it
+    }
+  Reply (worker.client, worker.seq, result);
+}
+
+inline void
+TrialServer::Loop (int listener)
+{
+  while (true)
+    {
+      while (m_workers.size () < m_jobs)
+        {
+          StartWorker (listener);
+        }
+      Dispatch ();
+
+      // forget clients that hung up and have had all their answers
+      for (std::map<uint32_t, Client>::iterator c = m_clients.begin (); c != m_clients.end (); )
+        {
+          if (c->second.eof && c->second.pending == 0)
+            {
+              if (listener >= 0)
+                {
+                  close (c->second.in);
+                }
+              m_clients.erase (c++);
+            }
+          else
+            {
+              ++c;
+            }
+        }
+      if (listener < 0 && m_clients.empty ())
+        {
+          break;
+        }
+
+      std::vector<struct pollfd> fds;
+      std::vector<uint32_t> owner; // client id, or worker index
+      std::vector<char> isWorker;
+      struct pollfd p;
+      p.events = POLLIN;
+      p.revents = 0;
+      if (listener >= 0)
+        {
+          p.fd = listener;
+          fds.push_back (p);
+          owner.push_back (0);
+          isWorker.push_back (2);
+        }
+      for (std::map<uint32_t, Client>::iterator c = m_clients.begin (); c != m_clients.end (); ++c)
+        {
+          if (!c->second.eof)
+            {
+              p.fd = c->second.in;
+              fds.push_back (p);
+              owner.push_back (c->first);
+              isWorker.push_back (0);
+            }
+        }
+      for (uint32_t w = 0; w < m_workers.size (); w++)
+        {
+          if (m_workers[w].busy)
+            {
+              p.fd = m_workers[w].reply;
+              fds.push_back (p);
+              owner.push_back (w);
+              isWorker.push_back (1);
+            }
+        }
+      if (poll (&fds[0], fds.size (), -1) < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+          NS_FATAL_ERROR ("poll failed: " << strerror (errno));
+        }
+
+      // workers last and backwards, so FinishWorker can erase them in place
+      for (uint32_t i = fds.size (); i-- > 0; )
+        {
+          if (fds[i].revents == 0)
+            {
+              continue;
+            }
+          if (isWorker[i] == 1)
+            {
+              char buf[4096];
+              ssize_t n = read (fds[i].fd, buf, sizeof (buf));
+              if (n > 0)
+                {
+                  m_workers[owner[i]].buffer.append (buf, n);
+                }
+              else if (n == 0 || errno != EINTR)
+                {
+                  FinishWorker (owner[i]);
+                }
+            }
+          else if (isWorker[i] == 0)
+            {
+              ReadClient (owner[i]);
+            }
+          else
+            {
+              int fd = accept (listener, 0, 0);
+              if (fd >= 0)
+                {
+                  Client client;
+                  client.in = fd;
+                  client.out = fd;
+                  client.eof = false;
+                  client.seq = 0;
+                  client.pending = 0;
+                  m_clients[m_nextClient++] = client;
+                }
+            }
+        }
+    }
+
+  // let the idle workers go
+  for (uint32_t w = 0; w < m_workers.size (); w++)
+    {
+      close (m_workers[w].request);
+      close (m_workers[w].reply);
+      while (waitpid (m_workers[w].pid, 0, 0) < 0 && errno == EINTR)
+        {
+        }
+    }
+  m_workers.clear ();
+}
+
+} // namespace ns3
+
+#endif /* TRIAL_SERVER_H */
@@ -0,0 +1,471 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TRIAL_H
+#define TRIAL_H
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/wifi-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/flow-monitor-module.h"
+#include "ns3/random-variable-stream.h"
+
+#include "scenario.h"
+#include "trial-result.h"
+#include "steady-state.h"
+#include "trial-cost.h"
+#include "grid-channel.h"
+#include "path-loss-cache.h"
+#include "block-fading.h"
+#include "error-table.h"
+#include "stratified-placement.h"
+#include "rate-managers.h"
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <math.h>
+#include <sys/time.h>
+
+namespace ns3 {
+
+inline double
+GetWallClock (void)
+{
+  struct timeval tv;
+  gettimeofday (&tv, 0);
+  return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+// installs the rate manager a trial's "manager" names, see rate-managers.h
+inline void
+SetRateManager (WifiHelper &wifi, const std::string &manager)
+{
+  RateManager m = GetRateManager (manager);
+  std::string names[8];
+  StringValue values[8];
+  for (uint32_t i = 0; i < m.attributes.size (); i++)
+    {
+      names[i] = m.attributes[i].first;
+      values[i] = StringValue (m.attributes[i].second);
+    }
+  wifi.SetRemoteStationManager (m.type, names[0], values[0], names[1], values[1], names[2], values[2],
+                                names[3], values[3], names[4], values[4], names[5], values[5],
+                                names[6], values[6], names[7], values[7]); // unnamed pairs are skipped
+}
+
+/*
+ * Whether the AP sends flow i (to station i) rather than receiving it.
+ * "random" tosses a coin per flow, drawn from the trial's direction
+ * stream, so the mix is the same on every platform for a given seed and
+ * run.  A fraction f makes that share of the flows downlink, spread
+ * evenly over the stations: flow i is downlink where floor ((i + 1) f)
+ * steps up.
+ */
+inline bool
+IsDownlink (const TrialSpec &spec, uint32_t i, Ptr<UniformRandomVariable> coin)
+{
+  if (spec.direction == "uplink" || spec.direction == "downlink")
+    {
+      return spec.direction == "downlink";
+    }
+  if (spec.direction == "random")
+    {
+      return coin->GetValue () < 0.5;
+    }
+  double f = ParseNumber ("direction", spec.direction);
+  return floor ((i + 1) * f + 1e-9) > floor (i * f + 1e-9);
+}
+
+/*
+ * Copies FlowMonitor's per-flow counters into the result, with each flow's
+ * throughput in Kib/s.  Without a measurement window a flow is measured
+ * over its own receive span: of its rxPackets equal-sized CBR packets,
+ * rxPackets - 1 arrive after the first one, between timeFirstRxPacket and
+ * timeLastRxPacket.  That leaves out the random start offset and the
+ * association delay, so the rate no longer depends on the trial duration.
+ * With a window, FlowMonitor only counted packets sent inside it.  With a
+ * steady-state monitor, the rate is the one it measured after truncation.
+ * Delay and jitter percentiles come from FlowMonitor's histograms, which
+ * are also merged into the trial's.
+ */
+inline void
+FlowOutput (Ptr<FlowMonitor> flowmon, FlowMonitorHelper *flowmonHelper, const TrialSpec &spec,
+            Ipv4Address apAddress, const SteadyStateMonitor *steady, TrialResult &result)
+{
+  Ptr<Ipv4FlowClassifier> classifier = DynamicCast<Ipv4FlowClassifier> (flowmonHelper->GetClassifier ());
+  std::map<FlowId, FlowMonitor::FlowStats> stats = flowmon->GetFlowStats (); // pull stats from flow monitor
+  for (std::map<FlowId, FlowMonitor::FlowStats>::const_iterator iter = stats.begin (); iter != stats.end (); ++iter)
+    {
+      Ipv4FlowClassifier::FiveTuple t = classifier->FindFlow (iter->first);
+      const FlowMonitor::FlowStats &st = iter->second;
+      FlowResult flow;
+      std::ostringstream src, dst;
+      src << t.sourceAddress;
+      dst << t.destinationAddress;
+      flow.source = src.str ();
+      flow.destination = dst.str ();
+      flow.direction = t.sourceAddress == apAddress ? "downlink" : "uplink";
+      flow.txBytes = st.txBytes;
+      flow.rxBytes = st.rxBytes;
+      flow.txPackets = st.txPackets;
+      flow.rxPackets = st.rxPackets;
+      flow.lostPackets = st.lostPackets;
+      flow.delaySum = st.delaySum.GetSeconds ();
+      flow.jitterSum = st.jitterSum.GetSeconds ();
+      flow.timeFirstTxPacket = st.timeFirstTxPacket.GetSeconds ();
+      flow.timeFirstRxPacket = st.timeFirstRxPacket.GetSeconds ();
+      flow.timeLastTxPacket = st.timeLastTxPacket.GetSeconds ();
+      flow.timeLastRxPacket = st.timeLastRxPacket.GetSeconds ();
+      DelayHistogram delays;
+      DelayHistogram jitters;
+      delays.Add (st.delayHistogram, spec.delayBin);
+      jitters.Add (st.jitterHistogram, spec.delayBin);
+      flow.delayP50 = delays.GetQuantile (0.50);
+      flow.delayP95 = delays.GetQuantile (0.95);
+      flow.delayP99 = delays.GetQuantile (0.99);
+      flow.jitterP50 = jitters.GetQuantile (0.50);
+      flow.jitterP95 = jitters.GetQuantile (0.95);
+      flow.jitterP99 = jitters.GetQuantile (0.99);
+      result.delays.Merge (delays);
+      result.jitters.Merge (jitters);
+
+      if (steady)
+        {
+          flow.throughput = steady->GetFlowThroughput (iter->first);
+        }
+      else if (spec.measureTo > 0)
+        {
+          flow.throughput = st.rxBytes * 8.0 / ((spec.measureTo - spec.measureFrom) * 1024); //bits per byte/window over bits per Kib
+        }
+      else if (st.rxPackets > 1 && flow.timeLastRxPacket > flow.timeFirstRxPacket)
+        {
+          double bytesAfterFirst = st.rxBytes * (st.rxPackets - 1.0) / st.rxPackets;
+          flow.throughput = bytesAfterFirst * 8.0 / ((flow.timeLastRxPacket - flow.timeFirstRxPacket) * 1024);
+        }
+
+      result.throughput += flow.throughput;
+      if (flow.direction == "uplink")
+        {
+          result.uplinkThroughput += flow.throughput;
+        }
+      else
+        {
+          result.downlinkThroughput += flow.throughput;
+        }
+      result.flows.push_back (flow);
+    }
+}
+
+/*
+ * One trial's world inside a simulation: its own nodes, channel and flow
+ * monitor, which nothing outside the copy can reach.
+ *
+ * Each component of the world draws from streams of its own, counted from
+ * a fixed base, so how many one component takes (the devices' grow with
+ * the stations, the channel's depend on the fading model) never moves
+ * another's.  Trials with the same seed and run, whatever their rate
+ * manager, fading or error model, then place their stations, start their
+ * flows and begin their fading from the same draws.
+ */
+struct TrialWorld
+{
+  static const int64_t STREAM_CHANNEL = 0;
+  static const int64_t STREAM_DEVICES = 1 << 20;
+  static const int64_t STREAM_PLACEMENT = 2 << 20;
+  static const int64_t STREAM_STACK = 3 << 20;
+  static const int64_t STREAM_START = 4 << 20;
+  static const int64_t STREAM_DIRECTION = 5 << 20;
+
+  TrialSpec spec;
+  FlowMonitorHelper *flowmonHelper;
+  Ptr<FlowMonitor> flowmon;
+  Ipv4Address apAddress;
+  uint64_t culled; // (transmitter, receiver) links left off the channel by cull
+};
+
+/*
+ * Builds the world described by spec into the current simulation.  All of
+ * its random variables are pinned to the streams above, so its result
+ * doesn't depend on what ran before it in this process, or on what else
+ * is built into the same simulation.
+ */
+inline void
+BuildWorld (const TrialSpec &spec, TrialWorld &world)
+{
+  world.spec = spec;
+  world.culled = 0;
+
+  NodeContainer wifiStaNodes; //create AP Node and (one or more) Station node(s)
+  wifiStaNodes.Create (spec.stations);
+  NodeContainer wifiApNode;
+  wifiApNode.Create (1);
+
+  Ptr<YansWifiChannel> wifiChannel = CreateObject<YansWifiChannel> (); //the channel's propagation models are built by hand below, not by YansWifiChannelHelper
+  Ptr<PropagationDelayModel> delay = CreateObject<ConstantSpeedPropagationDelayModel> ();
+  wifiChannel->SetPropagationDelayModel (delay);
+
+  Ptr<LogDistancePropagationLossModel> distanceLoss = CreateObject<LogDistancePropagationLossModel> ();
+  Ptr<PropagationLossModel> fadingLoss;
+  if (spec.fading == "rayleigh" && spec.fadingModel == "block")
+    {
+      fadingLoss = CreateObject<BlockRayleighPropagationLossModel> (); //same distribution, drawn a block at a time
+    }
+  else if (spec.fading == "rayleigh")
+    {
+      fadingLoss = CreateObject<NakagamiPropagationLossModel> (); //combining log and nakagami to have both distance and rayleigh fading (nakagami with m0, m1 and m2 = 1 is rayleigh)
+      fadingLoss->SetAttribute ("m0", DoubleValue (1.0));
+      fadingLoss->SetAttribute ("m1", DoubleValue (1.0));
+      fadingLoss->SetAttribute ("m2", DoubleValue (1.0));
+    }
+  Ptr<CachingPropagationLossModel> cachedLoss = CreateObject<CachingPropagationLossModel> (); //nodes never move, so the distance loss is worked out once per pair
+  cachedLoss->SetModels (distanceLoss, fadingLoss);
+  wifiChannel->SetPropagationLossModel (cachedLoss);
+
+  YansWifiPhyHelper phy = YansWifiPhyHelper::Default ();
+  phy.SetChannel (wifiChannel);
+  if (spec.errorModel == "table")
+    {
+      phy.SetErrorRateModel (TableErrorRateModel::GetTypeId ().GetName ()); //NIST from lookup tables, see error-table.h
+    }
+
+  WifiHelper wifi = WifiHelper::Default (); //create helper for the overall wifi setup and configure a station manager
+  wifi.SetStandard (WIFI_PHY_STANDARD_80211g);
+  SetRateManager (wifi, spec.manager);
+
+  NqosWifiMacHelper mac = NqosWifiMacHelper::Default (); //create a mac helper and configure for station and AP and install
+  Ssid ssid = Ssid ("example-ssid");
+  mac.SetType ("ns3::StaWifiMac",
+               "Ssid", SsidValue (ssid),
+               "ActiveProbing", BooleanValue (false));
+  NetDeviceContainer staDevices = wifi.Install (phy, mac, wifiStaNodes);
+  mac.SetType ("ns3::ApWifiMac",
+               "Ssid", SsidValue (ssid));
+  NetDeviceContainer apDevices = wifi.Install (phy, mac, wifiApNode);
+
+  wifiChannel->AssignStreams (TrialWorld::STREAM_CHANNEL); //each variable gets its stream before it first draws
+  int64_t stream = TrialWorld::STREAM_DEVICES;
+  stream += wifi.AssignStreams (staDevices, stream);
+  wifi.AssignStreams (apDevices, stream);
+
+  MobilityHelper mobilityAP;
+  Ptr<ListPositionAllocator> apPosition = CreateObject<ListPositionAllocator> ();
+  apPosition->Add (Vector (0.0, 0.0, 0.0)); //AP at the centre
+  mobilityAP.SetPositionAllocator (apPosition);
+  mobilityAP.SetMobilityModel ("ns3::ConstantPositionMobilityModel"); //nodes shouldn't move once placed
+  mobilityAP.Install (wifiApNode);
+
+  MobilityHelper mobilityST;
+  if (spec.placement == "line")
+    {
+      Ptr<ListPositionAllocator> staPositions = CreateObject<ListPositionAllocator> ();
+      for (uint32_t i = 0; i < spec.stations; i++)
+        {
+          staPositions->Add (Vector ((i + 1) * spec.distance, 0.0, 0.0));
+        }
+      mobilityST.SetPositionAllocator (staPositions);
+    }
+  else if (spec.placement == "stratified" || spec.placement == "antithetic")
+    {
+      Ptr<StratifiedDiscPositionAllocator> strata = CreateObject<StratifiedDiscPositionAllocator> (); // same disc, one ring and one sector per station
+      strata->SetDisc (spec.rhoMin, spec.rhoMax, spec.stations);
+      strata->SetAntithetic (spec.placement == "antithetic");
+      strata->AssignStreams (TrialWorld::STREAM_PLACEMENT);
+      mobilityST.SetPositionAllocator (strata);
+    }
+  else
+    {
+      std::ostringstream rho;
+      rho << "ns3::UniformRandomVariable[Min=" << spec.rhoMin << "|Max=" << spec.rhoMax << "]";
+      Ptr<RandomDiscPositionAllocator> disc = CreateObject<RandomDiscPositionAllocator> (); // random position on a "disk" around the AP
+      disc->SetAttribute ("X", DoubleValue (0.0));
+      disc->SetAttribute ("Y", DoubleValue (0.0));
+      disc->SetAttribute ("Rho", StringValue (rho.str ()));
+      disc->AssignStreams (TrialWorld::STREAM_PLACEMENT);
+      mobilityST.SetPositionAllocator (disc);
+    }
+  mobilityST.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobilityST.Install (wifiStaNodes);
+
+  if (spec.cull != "off")
+    {
+      GridWifiChannelHelper grid; //every device sends on a channel of its own, holding only the devices within range of it
+      grid.SetModels (cachedLoss, delay);
+      grid.SetRange (distanceLoss, ParseNumber ("cull", spec.cull),
+                     spec.fading == "rayleigh" ? 30.0 : 0.0); //a rayleigh power gain above 30 dB has probability e^-1000
+      NetDeviceContainer devices (staDevices, apDevices); //in the order they joined the shared channel
+      grid.Install (devices);
+      world.culled = grid.GetCulled ();
+    }
+
+  InternetStackHelper stack; //install the internet stack on all nodes
+  stack.Install (wifiApNode);
+  stack.Install (wifiStaNodes);
+  stream = TrialWorld::STREAM_STACK;
+  stream += stack.AssignStreams (wifiApNode, stream);
+  stack.AssignStreams (wifiStaNodes, stream);
+
+  Ipv4AddressGenerator::Reset (); //every copy is 10.1.1.0/24, as in a trial of its own; their channels never meet
+  Ipv4AddressHelper address; //assign IP addresses to all nodes
+  address.SetBase ("10.1.1.0", "255.255.255.0");
+  Ipv4InterfaceContainer stnAddress = address.Assign (staDevices);
+  Ipv4InterfaceContainer apAddress = address.Assign (apDevices);
+  world.apAddress = apAddress.GetAddress (0);
+
+  OnOffHelper onoff ("ns3::UdpSocketFactory", Address ()); //create a new on-off application to send data
+  onoff.SetConstantRate (spec.dataRate, spec.packetSize); //set the onoff client application to CBR mode
+
+  Ptr<UniformRandomVariable> coin = CreateObject<UniformRandomVariable> (); //only drawn from for a random direction
+  coin->SetStream (TrialWorld::STREAM_DIRECTION);
+
+  for (uint32_t i = 0; i < spec.stations; i++)
+    {
+      uint16_t port = 8000 + i; //one sink per flow, so each station's sink gets its own port
+      bool apSender = IsDownlink (spec, i, coin);
+      Ptr<Node> sender = apSender ? wifiApNode.Get (0) : wifiStaNodes.Get (i);
+      Ptr<Node> receiver = apSender ? wifiStaNodes.Get (i) : wifiApNode.Get (0);
+      Ipv4Address sinkAddress = apSender ? stnAddress.GetAddress (i) : apAddress.GetAddress (0);
+
+      onoff.SetAttribute ("Remote", AddressValue (InetSocketAddress (sinkAddress, port)));
+      ApplicationContainer apps = onoff.Install (sender);
+
+      Ptr<UniformRandomVariable> var = CreateObject<UniformRandomVariable> ();
+      var->SetStream (TrialWorld::STREAM_START + i);
+      apps.Start (Seconds (var->GetValue (0, 0.1)));
+      apps.Stop (Seconds (spec.duration));
+
+      PacketSinkHelper sink ("ns3::UdpSocketFactory", InetSocketAddress (sinkAddress, port));
+      apps.Add (sink.Install (receiver));
+    }
+
+  world.flowmonHelper = new FlowMonitorHelper; //create an install a flow monitor to monitor all transmissions around this copy's network
+  world.flowmonHelper->SetMonitorAttribute ("DelayBinWidth", DoubleValue (spec.delayBin));
+  world.flowmonHelper->SetMonitorAttribute ("JitterBinWidth", DoubleValue (spec.delayBin));
+  if (spec.measureTo > 0)
+    {
+      NS_ABORT_MSG_UNLESS (spec.measureFrom < spec.measureTo && spec.measureTo <= spec.duration,
+                           "measurement window must lie inside the trial");
+      world.flowmonHelper->SetMonitorAttribute ("StartTime", TimeValue (Seconds (spec.measureFrom)));
+    }
+  world.flowmon = world.flowmonHelper->Install (NodeContainer (wifiApNode, wifiStaNodes));
+  if (spec.measureTo > 0)
+    {
+      world.flowmon->Stop (Seconds (spec.measureTo));
+    }
+}
+
+/*
+ * Simulates the trials in specs together, each in a world of its own, and
+ * tears them down again.  Every trial gets exactly the result it would get
+ * alone, so this only saves the per-simulation overhead of small trials.
+ * Seeding and Simulator::Stop are global, so the trials must share seed,
+ * run and duration; a steady-state monitor stops the whole simulation, so
+ * sample needs a trial to itself.  What the trials cost cannot be told
+ * apart, so the first trial's result carries the whole batch's wall
+ * times, events and peak RSS and the others' carry none (costed false).
+ *
+ * The Simulator is a singleton, so only one batch can run per process at
+ * a time; SweepRunner gives each batch its own process.
+ */
+inline std::vector<TrialResult>
+RunTrials (const std::vector<TrialSpec> &specs)
+{
+  NS_ABORT_MSG_IF (specs.empty (), "no trials to run");
+  for (uint32_t k = 1; k < specs.size (); k++)
+    {
+      NS_ABORT_MSG_UNLESS (specs[k].seed == specs[0].seed && specs[k].run == specs[0].run
+                           && specs[k].duration == specs[0].duration,
+                           "trials simulated together must share seed, run and duration");
+    }
+  for (uint32_t k = 0; specs.size () > 1 && k < specs.size (); k++)
+    {
+      NS_ABORT_MSG_IF (specs[k].sample > 0, "trials with sample cannot share a simulation");
+    }
+
+  double wallStart = GetWallClock ();
+  ObjectFactory scheduler;
+  scheduler.SetTypeId (CountingScheduler::GetTypeId ());
+  Simulator::SetScheduler (scheduler);
+  CountingScheduler::ResetCount ();
+  SeedManager::SetSeed (specs[0].seed);
+  SeedManager::SetRun (specs[0].run);
+
+  std::vector<TrialWorld> worlds (specs.size ());
+  for (uint32_t k = 0; k < specs.size (); k++)
+    {
+      BuildWorld (specs[k], worlds[k]);
+    }
+
+  Simulator::Stop (Seconds (specs[0].duration));
+
+  const TrialSpec &spec = specs[0];
+  SteadyStateMonitor *steady = 0;
+  if (spec.sample > 0)
+    {
+      NS_ABORT_MSG_IF (spec.measureTo > 0, "sample and measure-to are mutually exclusive");
+      NS_ABORT_MSG_UNLESS (spec.measureFrom + spec.sample <= spec.duration, "warm-up plus one sample must fit in the trial");
+      steady = new SteadyStateMonitor (worlds[0].flowmon, spec.measureFrom, spec.sample, spec.steadyTol, 0.95);
+      steady->Start ();
+    }
+
+  double runStart = GetWallClock ();
+  Simulator::Run (); //run the simulation, collect the flow stats while the world still exists, then destroy it
+  double runEnd = GetWallClock ();
+  uint64_t events = CountingScheduler::GetCount ();
+  std::vector<TrialResult> results (worlds.size ());
+  for (uint32_t k = 0; k < worlds.size (); k++)
+    {
+      TrialResult &result = results[k];
+      worlds[k].flowmon->CheckForLostPackets (); //check all packets have been sent or completely lost
+      result.batch = worlds.size ();
+      result.costed = k == 0;
+      result.simSeconds = Simulator::Now ().GetSeconds ();
+      result.culled = worlds[k].culled;
+      if (steady)
+        {
+          result.steadyFrom = steady->GetStart ();
+        }
+      FlowOutput (worlds[k].flowmon, worlds[k].flowmonHelper, worlds[k].spec, worlds[k].apAddress, steady, result);
+    }
+  Simulator::Destroy ();
+  delete steady;
+  for (uint32_t k = 0; k < worlds.size (); k++)
+    {
+      delete worlds[k].flowmonHelper;
+    }
+
+  TrialResult &cost = results[0];
+  cost.wallSeconds = GetWallClock () - wallStart;
+  cost.setupSeconds = runStart - wallStart;
+  cost.runSeconds = runEnd - runStart;
+  cost.teardownSeconds = cost.wallSeconds - cost.setupSeconds - cost.runSeconds;
+  cost.events = events;
+  cost.peakRss = GetPeakRss ();
+  return results;
+}
+
+inline TrialResult
+RunTrial (const TrialSpec &spec)
+{
+  return RunTrials (std::vector<TrialSpec> (1, spec))[0];
+}
+
+} // namespace ns3
+
+#endif /* TRIAL_H */